@@ -19,9 +19,12 @@
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "riscv.h"
+#include "proc.h"
+#include "trace.h"
 #include "defs.h"
 #include "fs.h"
 #include "buf.h"
+#include "wchan.h"
 
 struct {
   struct spinlock lock;
@@ -38,7 +41,7 @@ binit(void)
 {
   struct buf *b;
 
-  initlock(&bcache.lock, "bcache");
+  initlock_kind(&bcache.lock, "bcache", SPIN_TICKET);
 
   // Create linked list of buffers
   bcache.head.prev = &bcache.head;
@@ -94,10 +97,15 @@ bread(uint dev, uint blockno)
 {
   struct buf *b;
 
+  trace(TR_BREAD, (uint64)dev << 32 | blockno);
   b = bget(dev, blockno);
   if(!b->valid) {
     virtio_disk_rw(b, 0);
     b->valid = 1;
+    if(myproc())
+      myproc()->io.cache_misses++;
+  } else if(myproc()) {
+    myproc()->io.cache_hits++;
   }
   return b;
 }
@@ -108,7 +116,10 @@ bwrite(struct buf *b)
 {
   if(!holdingsleep(&b->lock))
     panic("bwrite");
+  trace(TR_BWRITE, (uint64)b->dev << 32 | b->blockno);
   virtio_disk_rw(b, 1);
+  if(myproc())
+    myproc()->io.disk_writes++;
 }
 
 // Release a locked buffer.
@@ -150,4 +161,22 @@ bunpin(struct buf *b) {
   release(&bcache.lock);
 }
 
+// is chan a buffer's sleeplock, or a buffer waiting for the
+// disk (virtio_disk_rw() sleeps on it)?
+int
+buf_wchan(void *chan, uint64 *arg)
+{
+  struct buf *b;
 
+  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
+    if(chan == &b->lock){
+      *arg = (uint64)b->dev << 32 | b->blockno;
+      return WCHAN_BUF;
+    }
+    if(chan == b){
+      *arg = b->blockno;
+      return WCHAN_DISK;
+    }
+  }
+  return WCHAN_NONE;
+}
@@ -0,0 +1,11 @@
+// a process blocked in a system call, for ps_blocked().
+struct blocked_info {
+  int pid;
+  int syscall;        // number from a7, as it entered the kernel
+  uint64 args[6];     // a0..a5
+  int wchan;          // WCHAN_* kind, see wchan.h
+  int lock_holder;    // pid holding the sleeplock it waits for, 0 if none
+  uint64 wchan_arg;   // depends on wchan
+  uint64 blocked_us;  // microseconds since it went to sleep
+  char name[16];
+};
@@ -21,6 +21,7 @@
 #include "riscv.h"
 #include "defs.h"
 #include "proc.h"
+#include "wchan.h"
 
 #define BACKSPACE 0x100
 #define C(x)  ((x)-'@')  // Control-x
@@ -190,3 +191,13 @@ consoleinit(void)
   devsw[CONSOLE].read = consoleread;
   devsw[CONSOLE].write = consolewrite;
 }
+
+// is chan what consoleread() waits on for input?
+int
+console_wchan(void *chan, uint64 *arg)
+{
+  if(chan != &cons.r)
+    return WCHAN_NONE;
+  *arg = 0;
+  return WCHAN_CONSOLE;
+}
@@ -0,0 +1,6 @@
+struct cpu_info {
+  int cpu;
+  int pid;          // process running on it, 0 if none
+  uint64 tlb_sent;  // TLB shootdown IPIs sent
+  uint64 tlb_recv;  // TLB shootdown batches flushed
+};
@@ -0,0 +1,73 @@
+// Per-CPU rings of records, for trace.c and prof.c.
+//
+// Each ring has one writer, its CPU, which takes no lock: with
+// interrupts off it fills the slot cpuring_slot() gives it and
+// then publishes the record with cpuring_push(). Once the ring
+// is full, each new record overwrites the oldest one.
+//
+// Readers, serialized by the caller, drain a ring with
+// cpuring_read(). Record i sits in slot i % nrec, which the
+// writer reuses for record i + nrec while head is still
+// i + nrec, so record i is only whole while head - i < nrec:
+// the reader checks that again after copying each record and
+// drops the ones the writer lapped.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "cpuring.h"
+#include "defs.h"
+
+// The slot for the next record of r, whose nrec records of recsz
+// bytes each start at recs. nrec must be a power of two.
+void*
+cpuring_slot(struct cpuring *r, void *recs, int nrec, int recsz)
+{
+  return (char*)recs + (r->head % nrec) * recsz;
+}
+
+// Publish the record filled in at cpuring_slot().
+void
+cpuring_push(struct cpuring *r)
+{
+  __sync_synchronize();
+  r->head++;
+}
+
+// Copy up to n records of r not yet drained to user address buf,
+// in order. Records overwritten before they were drained are
+// lost. Returns how many were copied, or -1.
+int
+cpuring_read(struct cpuring *r, void *recs, int nrec, int recsz, uint64 buf, int n)
+{
+  struct proc *p = myproc();
+  uint64 head, start, end, i;
+  int cnt = 0;
+
+  head = r->head;
+  __sync_synchronize();
+  start = r->tail;
+  // the writer may be overwriting record head - nrec now.
+  if(head - start >= nrec)
+    start = head - nrec + 1;
+  end = head;
+  if(end - start > n)
+    end = start + n;
+
+  for(i = start; i < end; i++){
+    char *rec = (char*)recs + (i % nrec) * recsz;
+    if(copyout(p->pagetable, buf + cnt*recsz, rec, recsz) < 0)
+      return -1;
+    // did the writer lap us while we copied it? then the next
+    // record goes over it.
+    __sync_synchronize();
+    if(r->head - i >= nrec)
+      continue;
+    cnt++;
+  }
+  r->tail = end;
+  return cnt;
+}
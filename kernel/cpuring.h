@@ -0,0 +1,7 @@
+// the indices of a ring of fixed-size records kept per CPU, as
+// trace.c and prof.c do; see cpuring.c. the records themselves
+// follow in the caller's struct.
+struct cpuring {
+  volatile uint64 head;     // records written so far
+  uint64 tail;              // records drained so far
+};
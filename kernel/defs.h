@@ -1,3 +1,4 @@
+struct asid;
 struct buf;
 struct context;
 struct file;
@@ -7,6 +8,10 @@ struct proc;
 struct spinlock;
 struct sleeplock;
 struct stat;
+struct syscall_stat;
+struct fault_stat;
+struct cpuring;
+struct lathist;
 struct process_info;
 struct superblock;
 
@@ -17,11 +22,13 @@ void            brelse(struct buf*);
 void            bwrite(struct buf*);
 void            bpin(struct buf*);
 void            bunpin(struct buf*);
+int             buf_wchan(void*, uint64*);
 
 // console.c
 void            consoleinit(void);
 void            consoleintr(int);
 void            consputc(int);
+int             console_wchan(void*, uint64*);
 
 // exec.c
 int             exec(char*, char**);
@@ -35,6 +42,7 @@ int             fileread(struct file*, uint64, int n);
 int             filestat(struct file*, uint64 addr);
 int             filewrite(struct file*, uint64, int n);
 int             filecount(struct proc*);
+int             file_wchan(void*, uint64*);
 
 // fs.c
 void            fsinit(int);
@@ -55,6 +63,7 @@ int             readi(struct inode*, int, uint64, uint, uint);
 void            stati(struct inode*, struct stat*);
 int             writei(struct inode*, int, uint64, uint, uint);
 void            itrunc(struct inode*);
+int             inode_wchan(void*, uint64*);
 
 // ramdisk.c
 void            ramdiskinit(void);
@@ -71,26 +80,40 @@ void            initlog(int, struct superblock*);
 void            log_write(struct buf*);
 void            begin_op(void);
 void            end_op(void);
+int             log_wchan(void*);
 
 // pipe.c
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, uint64, int);
 int             pipewrite(struct pipe*, uint64, int);
+int             pipe_wchan(struct pipe*, void*, uint64*);
 
 // printf.c
 void            printf(char*, ...);
 void            panic(char*) __attribute__((noreturn));
 void            printfinit(void);
 
+// start.c
+int             timer_ticked(void);
+void            timer_set(uint64);
+void            timer_slice(void);
+int             timer_tick(void);
+
 // proc.c
 int             cpuid(void);
 void            exit(int);
 int             fork(void);
-int             growproc(int);
+int             growproc(int, uint64*);
 void            proc_mapstacks(pagetable_t);
 pagetable_t     proc_pagetable(struct proc *);
-void            proc_freepagetable(pagetable_t, uint64);
+int             proc_sharepagetable(struct proc *, struct proc *);
+int             proc_mappage(struct proc *, uint64, uint64, int);
+void            proc_freepagetable(pagetable_t, uint64, uint64);
+struct asid*    pagetable_asid(pagetable_t);
+void            pagetable_account(pagetable_t, int, int);
+int             clone(uint64, uint64, uint64, uint64);
+int             join(int);
 int             kill(int);
 int             killed(struct proc*);
 void            setkilled(struct proc*);
@@ -104,17 +127,31 @@ void            sleep(void*, struct spinlock*);
 void            userinit(void);
 int             wait(uint64);
 void            wakeup(void*);
+int             wakeup_n(void*, int);
+int             futex(uint64, int, int);
 void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
+int             proc_wchan(void*, uint64*);
 int		handle_ps(int limit, uint64 pids);
 int		handle_ps_info(int pid, uint64 psinfo);
+int		handle_ps_snapshot(uint64 buf, int n, uint64 gen);
 int		handle_ps_pt0(int pid, uint64 table);
 int		handle_ps_pt1(int pid, uint64 table, uint64 address);
 int		handle_ps_pt2(int pid, uint64 table, uint64 address);
+int		handle_ps_pt_walk(int pid, uint64 buf, int n);
 int		handle_ps_copy(int pid, uint64 addr, int size, uint64 data);
-int		handle_ps_sleep_write(int pid, uint64 addr);
+int		handle_process_vm(int pid, uint64 liov, int liovcnt, uint64 riov, int riovcnt, int write);
+int		handle_sched_setaffinity(int pid, uint mask);
+int		handle_sched_getaffinity(int pid, uint64 mask);
+int		handle_ps_cpus(uint64 buf, int n);
+int		handle_ps_syscalls(uint64 buf, int n);
+int		handle_ps_blocked(uint64 buf, int n);
+int		handle_ps_faults(uint64 buf);
+int		handle_trace(int pid, uint64 mask);
+int		handle_trace_read(int pid, uint64 buf, int n);
+void		strace_log(int num, uint64 *args, uint64 start, uint64 cycles, uint64 ret);
 
 
 // swtch.S
@@ -124,10 +161,23 @@ void            swtch(struct context*, struct context*);
 void            acquire(struct spinlock*);
 int             holding(struct spinlock*);
 void            initlock(struct spinlock*, char*);
+void            initlock_kind(struct spinlock*, char*, int);
 void            release(struct spinlock*);
 void            push_off(void);
 void            pop_off(void);
 
+// lockstat.c
+extern volatile int lockstat_on;
+void            lockstat_acquired(struct spinlock*, uint64, uint64, int);
+void            lockstat_released(struct spinlock*);
+int             lockstat_ctl(int);
+int             lockstat_read(uint64, int);
+int             lockbench(int, int);
+
+// ring.c
+uint64          ring_setup(void);
+int             ring_enter(int);
+
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
@@ -150,6 +200,8 @@ void            argaddr(int, uint64 *);
 int             fetchstr(uint64, char*, int);
 int             fetchaddr(uint64, uint64*);
 void            syscall();
+uint64          syscall_run(int);
+void            syscall_stat_sum(int, struct syscall_stat*);
 
 // sysproc.c
 uint64		sys_uptime(void);
@@ -160,6 +212,44 @@ void            trapinit(void);
 void            trapinithart(void);
 extern struct spinlock tickslock;
 void            usertrapret(void);
+void            ticksync(void);
+
+// timer.c
+void            wheelinit(void);
+void            timer_run(void);
+uint64          timer_next(void);
+int             timer_sleep(uint64);
+
+// cpuring.c
+void*           cpuring_slot(struct cpuring*, void*, int, int);
+void            cpuring_push(struct cpuring*);
+int             cpuring_read(struct cpuring*, void*, int, int, uint64, int);
+
+// lathist.c
+void            lathist_add(struct lathist*, uint64);
+void            lathist_sum(struct lathist*, struct lathist*);
+
+// fault.c
+int             pagefault(uint64, uint64);
+void            fault_stat_sum(struct fault_stat*);
+
+// trace.c
+void            traceinit(void);
+void            trace(int, uint64);
+int             ktrace_ctl(int);
+int             ktrace_read(uint64, int);
+
+// prof.c
+void            profinit(void);
+void            prof_tick(int, uint64, uint64);
+int             prof_ctl(int);
+int             prof_read(uint64, int);
+
+// tlb.c
+void            tlb_shootdown(pagetable_t, uint64, uint64);
+void            tlb_flush(void);
+void            asidinit(void);
+uint64          asid_satp(pagetable_t, struct asid*);
 
 // uart.c
 void            uartinit(void);
@@ -167,6 +257,7 @@ void            uartintr(void);
 void            uartputc(int);
 void            uartputc_sync(int);
 int             uartgetc(void);
+int             uart_wchan(void*, uint64*);
 
 // vm.c
 void            kvminit(void);
@@ -197,6 +288,11 @@ void            plic_complete(int);
 void            virtio_disk_init(void);
 void            virtio_disk_rw(struct buf *, int);
 void            virtio_disk_intr(void);
+int             disk_wchan(void*);
+
+// wchan.c
+int             wchan_classify(void*, uint64*);
+char*           wchan_sleeplock(int, void*, int*);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
@@ -121,18 +121,23 @@ exec(char *path, char **argv)
   safestrcpy(p->name, last, sizeof(p->name));
     
   // Commit to the user image.
+  // A thread leaves its shared address space behind
+  // (it is still reaped by join()).
   oldpagetable = p->pagetable;
+  uint64 oldtrapframe_va = p->trapframe_va;
+  p->trapframe_va = TRAPFRAME;
   p->pagetable = pagetable;
+  p->asid = pagetable_asid(pagetable);
   p->sz = sz;
   p->trapframe->epc = elf.entry;  // initial program counter = main
   p->trapframe->sp = sp; // initial stack pointer
-  proc_freepagetable(oldpagetable, oldsz);
+  proc_freepagetable(oldpagetable, oldsz, oldtrapframe_va);
 
   return argc; // this ends up in a0, the first argument to main(argc, argv)
 
  bad:
   if(pagetable)
-    proc_freepagetable(pagetable, sz);
+    proc_freepagetable(pagetable, sz, TRAPFRAME);
   if(ip){
     iunlockput(ip);
     end_op();
@@ -0,0 +1,85 @@
+// User page faults.
+//
+// usertrap() hands instruction, load and store page faults to
+// pagefault(), which decides whether the access can be retried
+// and counts each fault by kind, per CPU for the whole system
+// and in the faulting process, with a histogram of how long
+// handling took. ktrace records each one as a TR_FAULT event,
+// the faulting page and the kind, for working-set analysis.
+//
+// All memory is mapped eagerly, so the only faults that can be
+// served are minor ones: threads share a page table, and a hart
+// may still hold the invalid translation of a page that another
+// thread has since mapped with sbrk(). Zero-fill, copy-on-write
+// and page-cache faults have their kinds and counters ready for
+// lazy allocation, COW fork and mapped files.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "trace.h"
+#include "lathist.h"
+#include "fault.h"
+#include "defs.h"
+
+struct fault_stat faultstats[NCPU];
+
+// count a fault of kind that took cycles to handle.
+static void
+fault_count(struct proc *p, int kind, uint64 cycles)
+{
+  struct fault_stat *s;
+
+  switch(kind){
+  case FAULT_MINOR:     p->faults.minor++; break;
+  case FAULT_ZERO:      p->faults.zero++; break;
+  case FAULT_COW:       p->faults.cow++; break;
+  case FAULT_PAGECACHE: p->faults.pagecache++; break;
+  default:              p->faults.bad++; break;
+  }
+
+  push_off();
+  s = &faultstats[cpuid()];
+  s->faults[kind]++;
+  lathist_add(&s->lat, cycles);
+  pop_off();
+}
+
+// Handle a page fault by the current process in user mode, with
+// scause 12 (instruction), 13 (load) or 15 (store) at va.
+// Returns 0 if the access can be retried, -1 if it cannot.
+int
+pagefault(uint64 scause, uint64 va)
+{
+  struct proc *p = myproc();
+  uint64 start = r_time();
+  int need = scause == 12 ? PTE_X : scause == 13 ? PTE_R : PTE_W;
+  int kind = FAULT_BAD;
+  pte_t *pte;
+
+  if(va < MAXVA && (pte = walk(p->pagetable, va, 0)) != 0 &&
+     (*pte & (PTE_V|PTE_U|need)) == (PTE_V|PTE_U|need)){
+    sfence_vma_va(PGROUNDDOWN(va));
+    kind = FAULT_MINOR;
+  }
+
+  fault_count(p, kind, r_time() - start);
+  trace(TR_FAULT, PGROUNDDOWN(va) | kind);
+  return kind == FAULT_BAD ? -1 : 0;
+}
+
+// Sum the counters of all CPUs into *s.
+void
+fault_stat_sum(struct fault_stat *s)
+{
+  memset(s, 0, sizeof(*s));
+  for(int i = 0; i < NCPU; i++){
+    struct fault_stat *c = &faultstats[i];
+    for(int k = 0; k < NFAULT; k++)
+      s->faults[k] += c->faults[k];
+    lathist_sum(&s->lat, &c->lat);
+  }
+}
@@ -0,0 +1,13 @@
+// kinds of user page fault, as counted by pagefault().
+#define FAULT_MINOR      0   // page already mapped: a stale TLB entry, flushed
+#define FAULT_ZERO       1   // a zero-filled page allocated
+#define FAULT_COW        2   // a copy-on-write page copied
+#define FAULT_PAGECACHE  3   // a page mapped from the page cache
+#define FAULT_BAD        4   // no mapping allows the access: killed
+#define NFAULT           5
+
+// page faults taken, summed over all CPUs.
+struct fault_stat {
+  uint64 faults[NFAULT];     // by kind
+  struct lathist lat;        // time handling them, see lathist.h
+};
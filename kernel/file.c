@@ -12,6 +12,7 @@
 #include "file.h"
 #include "stat.h"
 #include "proc.h"
+#include "wchan.h"
 
 struct devsw devsw[NDEV];
 struct {
@@ -126,6 +127,9 @@ fileread(struct file *f, uint64 addr, int n)
     panic("fileread");
   }
 
+  myproc()->io.syscr++;
+  if(r > 0)
+    myproc()->io.rchar += r;
   return r;
 }
 
@@ -177,6 +181,9 @@ filewrite(struct file *f, uint64 addr, int n)
     panic("filewrite");
   }
 
+  myproc()->io.syscw++;
+  if(ret > 0)
+    myproc()->io.wchar += ret;
   return ret;
 }
 
@@ -195,3 +202,20 @@ filecount(struct proc* p) {
   release(&ftable.lock);
   return files_count;
 }
+
+// is chan where a reader or writer of an open pipe waits?
+int
+file_wchan(void *chan, uint64 *arg)
+{
+  struct file *f;
+  int kind = WCHAN_NONE;
+
+  acquire(&ftable.lock);
+  for(f = ftable.file; f < ftable.file + NFILE; f++){
+    if(f->ref > 0 && f->type == FD_PIPE &&
+       (kind = pipe_wchan(f->pipe, chan, arg)) != WCHAN_NONE)
+      break;
+  }
+  release(&ftable.lock);
+  return kind;
+}
@@ -20,6 +20,7 @@
 #include "fs.h"
 #include "buf.h"
 #include "file.h"
+#include "wchan.h"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 // there should be one superblock per disk device, but we run with
@@ -326,6 +327,21 @@ iunlock(struct inode *ip)
   releasesleep(&ip->lock);
 }
 
+// is chan an inode's sleeplock?
+int
+inode_wchan(void *chan, uint64 *arg)
+{
+  struct inode *ip;
+
+  for(ip = &itable.inode[0]; ip < &itable.inode[NINODE]; ip++){
+    if(chan == &ip->lock){
+      *arg = (uint64)ip->dev << 32 | ip->inum;
+      return WCHAN_INODE;
+    }
+  }
+  return WCHAN_NONE;
+}
+
 // Drop a reference to an in-memory inode.
 // If that was the last reference, the inode table entry can
 // be recycled.
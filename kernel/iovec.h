@@ -0,0 +1,8 @@
+// a buffer in a process's memory, for process_vm_readv()
+// and process_vm_writev().
+struct iovec {
+  uint64 base;  // user virtual address
+  uint64 len;   // in bytes
+};
+
+#define IOV_MAX 1024  // iovecs per call
@@ -7,6 +7,7 @@
 #include "memlayout.h"
 #include "spinlock.h"
 #include "riscv.h"
+#include "trace.h"
 #include "defs.h"
 
 void freerange(void *pa_start, void *pa_end);
@@ -26,7 +27,7 @@ struct {
 void
 kinit()
 {
-  initlock(&kmem.lock, "kmem");
+  initlock_kind(&kmem.lock, "kmem", SPIN_TICKET);
   freerange(end, (void*)PHYSTOP);
 }
 
@@ -51,6 +52,8 @@ kfree(void *pa)
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("kfree");
 
+  trace(TR_KFREE, (uint64)pa);
+
   // Fill with junk to catch dangling refs.
   memset(pa, 1, PGSIZE);
 
@@ -76,7 +79,9 @@ kalloc(void)
     kmem.freelist = r->next;
   release(&kmem.lock);
 
-  if(r)
+  if(r){
     memset((char*)r, 5, PGSIZE); // fill with junk
+    trace(TR_KALLOC, (uint64)r);
+  }
   return (void*)r;
 }
@@ -0,0 +1,30 @@
+// Latency histograms with log2 buckets, for the per-CPU system
+// call and page fault counters. Callers keep a histogram per
+// CPU and update it with interrupts off, so no lock is taken.
+
+#include "types.h"
+#include "param.h"
+#include "riscv.h"
+#include "lathist.h"
+#include "defs.h"
+
+// count an event that took cycles in h.
+void
+lathist_add(struct lathist *h, uint64 cycles)
+{
+  int b;
+
+  for(b = 0; b < NLATBUCKET - 1 && (cycles >> (b+1)) != 0; b++)
+    ;
+  h->cycles += cycles;
+  h->hist[b]++;
+}
+
+// add the counts in h to *sum.
+void
+lathist_sum(struct lathist *sum, struct lathist *h)
+{
+  sum->cycles += h->cycles;
+  for(int b = 0; b < NLATBUCKET; b++)
+    sum->hist[b] += h->hist[b];
+}
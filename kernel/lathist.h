@@ -0,0 +1,9 @@
+#define NLATBUCKET 24  // log2 latency buckets
+
+// how long events took, in time CSR cycles, for the system call
+// and page fault counters; see lathist.c.
+struct lathist {
+  uint64 cycles;            // total time CSR cycles
+  uint64 hist[NLATBUCKET];  // hist[i]: events taking < 2^(i+1) cycles
+                            // (and >= 2^i, except in the last one)
+};
@@ -0,0 +1,203 @@
+// Spinlock contention statistics.
+//
+// With LOCKSTAT, and while lockstat_ctl() has them on, acquire()
+// and release() count for each lock how often it was taken, how
+// often it had to spin, and how long it spun and was held. Locks
+// are counted by name, so all the "proc" locks add up in one
+// entry: the first acquire() of a lock finds or claims its name's
+// slot and remembers it in lk->stat.
+//
+// This runs inside acquire() and release(), so it takes no lock:
+// slots are claimed with compare-and-swap, and each CPU counts
+// in its own table, with interrupts off, which lockstat_read()
+// sums. Nor does lockstat_ctl() write other CPUs' tables: it bumps
+// a generation, and each CPU zeroes its own table when it next
+// counts.
+//
+// lockbench() hammers a lock of each kind, to compare them.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "lockstat.h"
+#include "defs.h"
+
+struct lockcount {
+  uint64 acquires;
+  uint64 contended;
+  uint64 spin_cycles;
+  uint64 spin_max;
+  uint64 hold_cycles;
+  uint64 hold_max;
+};
+
+char *locknames[NLOCKSTAT];
+struct lockcount lockcounts[NCPU][NLOCKSTAT];
+uint64 lockgen[NCPU];           // generation each table was zeroed at
+volatile uint64 lockstat_gen;   // bumped by lockstat_ctl() to zero them
+
+volatile int lockstat_on;
+
+// lk's slot in locknames, or -1 if it has no name or there
+// are no free slots left.
+static int
+lockstat_slot(struct spinlock *lk)
+{
+  int i;
+
+  if(lk->stat != 0)
+    return lk->stat - 1;
+  if(lk->name == 0)
+    return -1;
+  for(i = 0; i < NLOCKSTAT; i++){
+    if(locknames[i] == 0 &&
+       __sync_bool_compare_and_swap(&locknames[i], 0, lk->name))
+      break;
+    if(locknames[i] == lk->name || strncmp(locknames[i], lk->name, 16) == 0)
+      break;
+  }
+  if(i == NLOCKSTAT)
+    return -1;
+  lk->stat = i + 1;
+  return i;
+}
+
+// this CPU's table, zeroed if counting restarted since it last
+// counted. interrupts are off.
+static struct lockcount *
+lockstat_table(void)
+{
+  int cpu = cpuid();
+  uint64 gen = lockstat_gen;
+
+  if(lockgen[cpu] != gen){
+    memset(lockcounts[cpu], 0, sizeof(lockcounts[cpu]));
+    __sync_synchronize();
+    lockgen[cpu] = gen;
+  }
+  return lockcounts[cpu];
+}
+
+// lk was acquired at now, after spinning since start if spun.
+// interrupts are off.
+void
+lockstat_acquired(struct spinlock *lk, uint64 start, uint64 now, int spun)
+{
+  int i = lockstat_slot(lk);
+  struct lockcount *c;
+
+  if(i < 0)
+    return;
+  c = &lockstat_table()[i];
+  c->acquires++;
+  if(spun){
+    uint64 spin = now - start;
+    c->contended++;
+    c->spin_cycles += spin;
+    if(spin > c->spin_max)
+      c->spin_max = spin;
+  }
+  lk->acquired = now;
+}
+
+// lk, acquired while counting, is about to be released.
+// interrupts are off.
+void
+lockstat_released(struct spinlock *lk)
+{
+  uint64 hold = r_time() - lk->acquired;
+  struct lockcount *c;
+
+  lk->acquired = 0;
+  if(lk->stat == 0)
+    return;
+  c = &lockstat_table()[lk->stat - 1];
+  c->hold_cycles += hold;
+  if(hold > c->hold_max)
+    c->hold_max = hold;
+}
+
+// Turn counting on, from zero, or off.
+// Returns whether it was on.
+int
+lockstat_ctl(int on)
+{
+  int old = lockstat_on;
+
+  if(!LOCKSTAT)
+    return -1;
+  lockstat_on = 0;
+  if(on){
+    __sync_fetch_and_add(&lockstat_gen, 1);
+    lockstat_on = 1;
+  }
+  return old;
+}
+
+// Copy up to n struct lock_stat, one per lock name seen, to user
+// address buf. Returns how many were copied.
+int
+lockstat_read(uint64 buf, int n)
+{
+  struct proc *p = myproc();
+  struct lock_stat s;
+  int i, cnt = 0;
+
+  for(i = 0; i < NLOCKSTAT && cnt < n && locknames[i]; i++){
+    memset(&s, 0, sizeof(s));
+    safestrcpy(s.name, locknames[i], sizeof(s.name));
+    for(int cpu = 0; cpu < NCPU; cpu++){
+      struct lockcount *c = &lockcounts[cpu][i];
+      if(lockgen[cpu] != lockstat_gen)
+        continue;  // not counted since counting restarted
+      s.acquires += c->acquires;
+      s.contended += c->contended;
+      s.spin_cycles += c->spin_cycles;
+      s.hold_cycles += c->hold_cycles;
+      if(c->spin_max > s.spin_max)
+        s.spin_max = c->spin_max;
+      if(c->hold_max > s.hold_max)
+        s.hold_max = c->hold_max;
+    }
+    if(copyout(p->pagetable, buf + cnt*sizeof(s), (char*)&s, sizeof(s)) < 0)
+      return -1;
+    cnt++;
+  }
+  return cnt;
+}
+
+// for lockbench(): a lock of each kind, and what they guard.
+struct spinlock benchlocks[] = {
+  [SPIN_TAS]    { .name = "bench_tas", .kind = SPIN_TAS },
+  [SPIN_TICKET] { .name = "bench_ticket", .kind = SPIN_TICKET },
+};
+volatile uint64 benchcount;
+
+// Take and release the benchmark lock of kind, bumping a counter
+// it guards, for ms milliseconds. Run on several harts at once
+// to compare the kinds under contention.
+// Returns how many times it got the lock, or -1.
+int
+lockbench(int kind, int ms)
+{
+  struct spinlock *lk;
+  uint64 end;
+  int n = 0;
+
+  if(kind < 0 || kind >= NELEM(benchlocks) || ms <= 0)
+    return -1;
+  lk = &benchlocks[kind];
+  end = r_time() + (uint64)ms * (TIMEBASE / 1000);
+  while(r_time() < end){
+    acquire(lk);
+    benchcount++;
+    release(lk);
+    // interrupts are on between rounds; check for kill() now and then.
+    if((++n & 1023) == 0 && killed(myproc()))
+      break;
+  }
+  return n;
+}
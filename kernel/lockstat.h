@@ -0,0 +1,13 @@
+#define NLOCKSTAT 64  // lock names counted; locks past that are not
+
+// contention of the spinlocks with one name, summed over all of
+// them and all CPUs. times are in time CSR cycles.
+struct lock_stat {
+  char name[16];
+  uint64 acquires;
+  uint64 contended;     // acquires that had to spin
+  uint64 spin_cycles;   // total time spent spinning
+  uint64 spin_max;
+  uint64 hold_cycles;   // total time held
+  uint64 hold_max;
+};
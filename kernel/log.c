@@ -4,8 +4,10 @@
 #include "param.h"
 #include "spinlock.h"
 #include "sleeplock.h"
+#include "proc.h"
 #include "fs.h"
 #include "buf.h"
+#include "wchan.h"
 
 // Simple logging that allows concurrent FS system calls.
 //
@@ -230,7 +232,14 @@ log_write(struct buf *b)
   if (i == log.lh.n) {  // Add new block to log?
     bpin(b);
     log.lh.n++;
+    myproc()->io.log_blocks++;
   }
   release(&log.lock);
 }
 
+// is chan the log, which begin_op() waits for?
+int
+log_wchan(void *chan)
+{
+  return chan == &log ? WCHAN_LOG : WCHAN_NONE;
+}
@@ -19,8 +19,12 @@ main()
     kinit();         // physical page allocator
     kvminit();       // create kernel page table
     kvminithart();   // turn on paging
+    asidinit();      // user address space identifiers
     procinit();      // process table
     trapinit();      // trap vectors
+    wheelinit();     // sleep() deadlines
+    traceinit();     // kernel tracepoints
+    profinit();      // sampling profiler
     trapinithart();  // install kernel trap vector
     plicinit();      // set up interrupt controller
     plicinithart();  // ask PLIC for device interrupts
@@ -25,11 +25,19 @@
 #define VIRTIO0 0x10001000
 #define VIRTIO0_IRQ 1
 
-// core local interruptor (CLINT), which contains the timer.
+// core local interruptor (CLINT), which contains the timer
+// and the inter-processor (machine software) interrupt bits.
 #define CLINT 0x2000000L
+#define CLINT_MSIP(hartid) (CLINT + 4*(hartid))
 #define CLINT_MTIMECMP(hartid) (CLINT + 0x4000 + 8*(hartid))
 #define CLINT_MTIME (CLINT + 0xBFF8) // cycles since boot.
 
+// the CLINT's mtime, and so the time CSR, counts at this rate.
+#define TIMEBASE 10000000L
+
+// cycles between clock ticks; about 1/10th second in qemu.
+#define TICK_INTERVAL 1000000
+
 // qemu puts platform-level interrupt controller (PLIC) here.
 #define PLIC 0x0c000000L
 #define PLIC_PRIORITY (PLIC + 0x0)
@@ -62,6 +70,19 @@
 //   fixed-size stack
 //   expandable heap
 //   ...
+//   ...
+//   RING (struct ring, once ring_setup() is called)
+//   THREADFRAME(i) (trapframes of threads)
+//   VDSO (struct vdso, read-only to the user)
 //   TRAPFRAME (p->trapframe, used by the trampoline)
 //   TRAMPOLINE (the same page as in the kernel)
 #define TRAPFRAME (TRAMPOLINE - PGSIZE)
+#define VDSO (TRAPFRAME - PGSIZE)
+
+// threads made by clone() share their creator's page table, so
+// each one's trapframe gets its own page below VDSO,
+// indexed by proc slot.
+#define THREADFRAME(i) (VDSO - ((i)+1)*PGSIZE)
+
+// the system call ring, below the last THREADFRAME.
+#define RING THREADFRAME(NPROC)
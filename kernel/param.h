@@ -1,5 +1,9 @@
 #define NPROC        64  // maximum number of processes
 #define NCPU          8  // maximum number of CPUs
+#define NTLBBATCH    16  // max pages per TLB shootdown request
+#define ASID          1  // tag user TLB entries with ASIDs (0: flush on switch)
+#define TICKLESS      1  // one-shot clock interrupts, none on idle CPUs
+#define LOCKSTAT      1  // spinlock contention statistics, see lockstat.c
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
 #define NINODE       50  // maximum number of active i-nodes
@@ -7,6 +7,7 @@
 #include "fs.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "wchan.h"
 
 #define PIPESIZE 512
 
@@ -128,3 +129,18 @@ piperead(struct pipe *pi, uint64 addr, int n)
   release(&pi->lock);
   return i;
 }
+
+// is chan where a reader or writer of pi waits?
+int
+pipe_wchan(struct pipe *pi, void *chan, uint64 *arg)
+{
+  if(chan == &pi->nread){
+    *arg = 0;
+    return WCHAN_PIPE;
+  }
+  if(chan == &pi->nwrite){
+    *arg = 1;
+    return WCHAN_PIPE;
+  }
+  return WCHAN_NONE;
+}
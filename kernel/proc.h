@@ -19,15 +19,62 @@ struct context {
 };
 
 // Per-CPU state.
+// address space identifier of a user page table; see tlb.c.
+struct asid {
+  uint64 gen;                 // generation asid belongs to, 0 if none yet
+  uint asid;
+  uint cpumask;               // CPUs that used asid during generation gen
+};
+
+// a deadline for a sleeping process; see timer.c.
+struct timer {
+  uint64 expires;             // time CSR value to wake up at
+  int pending;                // queued in the timer wheel?
+  int level;                  // wheel level it is queued in
+  struct timer *next;         // next in its wheel slot
+  struct timer **pprev;       // what points to it
+};
+
+// I/O a process has done, counted where it happens on its
+// behalf. only it updates them; ps reads them without a lock.
+struct ioacct {
+  uint64 rchar;               // bytes fileread() returned
+  uint64 wchar;               // bytes filewrite() wrote
+  uint syscr;                 // fileread() calls
+  uint syscw;                 // filewrite() calls
+  uint cache_hits;            // bread()s found valid in the buffer cache
+  uint cache_misses;          // bread()s that read the block from disk
+  uint disk_writes;           // blocks bwrite() wrote to disk
+  uint log_blocks;            // blocks log_write() added to the log
+};
+
+// page faults a process has taken, by kind; see fault.c.
+struct faultacct {
+  uint minor;
+  uint zero;
+  uint cow;
+  uint pagecache;
+  uint bad;
+};
+
 struct cpu {
   struct proc *proc;          // The process running on this cpu, or null.
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  int started;                // Has this CPU entered scheduler()?
+  uint64 tlb_sent;            // TLB shootdown IPIs sent to other CPUs
+  uint64 tlb_recv;            // TLB shootdown batches flushed here
+  uint64 asid_gen;            // ASID generation the TLB was flushed for
+  int idle;                   // Waiting in wfi for something to run?
+  struct spinlock *spinning;  // Lock acquire() is spinning on, for ps.
 };
 
 extern struct cpu cpus[NCPU];
 
+// affinity mask allowing a process to run on every CPU.
+#define CPUMASK_ALL ((1 << NCPU) - 1)
+
 // per-process data for the trap handling code in trampoline.S.
 // sits in a page by itself just under the trampoline page in the
 // user page table. not specially mapped in the kernel page table.
@@ -92,22 +139,38 @@ struct proc {
   int xstate;                  // Exit status to be returned to parent's wait
   int pid;                     // Process ID
 
-  // wait_lock must be held when using this:
+  // wait_lock must be held when using these:
   struct proc *parent;         // Parent process
+  int thread;                  // Made by clone(), reaped by join() not wait()
 
   // these are private to the process, so p->lock need not be held.
   uint64 kstack;               // Virtual address of kernel stack
   uint64 sz;                   // Size of process memory (bytes)
   pagetable_t pagetable;       // User page table
   struct trapframe *trapframe; // data page for trampoline.S
+  uint64 trapframe_va;         // where trapframe is mapped in pagetable
+  struct asid *asid;           // pagetable's ASID
   struct context context;      // swtch() here to run process
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+  struct ioacct io;            // I/O done on its behalf
+  struct faultacct faults;     // page faults taken
   
   // also use p->lock
   uint init_ticks;	       // Processor ticks at creation moment
-  uint run_time;               // Total time in running state
-  uint last_run_start;	       // Time of last switch to running state 
+  uint64 utime;                // time CSR cycles spent in user mode
+  uint64 stime;                // cycles spent running in the kernel
+  uint64 wtime;                // cycles spent RUNNABLE, waiting for a CPU
+  uint64 acct_start;           // time CSR at the start of the current one
+  uint64 sleep_start;          // time CSR when it last went to sleep
+  struct timer timer;          // deadline of sleep() and nanosleep()
   uint context_switches;       // Number of context switches
+  uint syscalls;               // system calls made; bumped without p->lock
+  uint cpumask;                // CPUs allowed to run this process, bit per hart
+  int last_cpu;                // CPU this process last ran on, -1 if never
+  uint64 tracemask;            // system calls to log, a bit per number
+  struct strace_rec *strace;   // page of logged calls, once traced
+  uint64 strace_head;          // calls logged
+  uint64 strace_tail;          // calls read by trace_read()
 };
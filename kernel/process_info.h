@@ -10,4 +10,32 @@ struct process_info {
   uint proc_ticks;
   uint run_time;
   uint context_switches;
+  int last_cpu;
+  uint cpumask;
+  uint64 utime_us;   // microseconds in user mode
+  uint64 stime_us;   // microseconds running in the kernel
+  uint64 wait_us;    // microseconds runnable but waiting for a CPU
+  int pid;
+  int rss_pages;     // user pages mapped
+  int shared_pages;  // of those, shared with other processes (its threads)
+  int pt_pages;      // page-table pages
+  int kernel_pages;  // kernel stack, trapframe and the like
+  uint syscalls;     // system calls made
+  int wchan;         // what it waits for, WCHAN_* from wchan.h
+  int lock_holder;   // pid holding the lock it waits for, 0 if none
+  uint64 wchan_arg;  // depends on wchan
+  char lock_name[NAME_SIZE];  // the lock it waits for, if any
+  uint64 read_bytes;   // bytes read()
+  uint64 write_bytes;  // bytes written by write()
+  uint reads;          // read() calls
+  uint writes;         // write() calls
+  uint cache_hits;     // blocks found in the buffer cache
+  uint cache_misses;   // blocks read from disk
+  uint disk_writes;    // blocks written to disk
+  uint log_blocks;     // blocks it added to the log to be committed
+  uint minor_faults;   // page faults on pages already mapped
+  uint zero_faults;    // page faults allocating a zero-filled page
+  uint cow_faults;     // page faults copying a copy-on-write page
+  uint cache_faults;   // page faults served from the page cache
+  uint bad_faults;     // page faults no mapping allowed: they kill
 };
@@ -0,0 +1,129 @@
+// Sampling profiler.
+//
+// While it is on, every clock interrupt records where the
+// interrupted code was: the pc and the return addresses found
+// by following the frame pointer chain (everything is built
+// with -fno-omit-frame-pointer), into a ring buffer of the
+// current CPU. As with trace.c, each buffer has one writer and
+// prof_read() drains them all.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "prof.h"
+#include "cpuring.h"
+#include "defs.h"
+
+#define NPROF 512  // samples per CPU, a power of two
+
+struct profbuf {
+  struct cpuring ring;
+  struct prof_sample s[NPROF];
+} profbufs[NCPU];
+
+volatile int prof_on;
+
+// serializes readers.
+struct spinlock prof_lock;
+
+void
+profinit(void)
+{
+  initlock(&prof_lock, "prof");
+}
+
+// the frame at fp keeps the return address at fp-8 and the
+// caller's frame pointer at fp-16. the chain is only followed
+// up the page holding the first frame, a stack page, since a
+// leaf function may not save ra and leave junk where the next
+// frame pointer ought to be.
+static void
+walk_stack(struct prof_sample *s, int user, uint64 fp)
+{
+  struct proc *p = myproc();
+  uint64 lo = PGROUNDDOWN(fp - 16);
+  uint64 frame[2];  // caller's fp, return address
+
+  while(s->depth < PROF_DEPTH){
+    if(fp < lo + 16 || fp > lo + PGSIZE || (fp & 7) != 0)
+      break;
+    if(user){
+      if(copyin(p->pagetable, (char*)frame, fp - 16, sizeof(frame)) < 0)
+        break;
+    } else {
+      frame[0] = *(uint64*)(fp - 16);
+      frame[1] = *(uint64*)(fp - 8);
+    }
+    if(frame[1] == 0)
+      break;
+    s->pc[s->depth++] = frame[1];
+    if(frame[0] <= fp)
+      break;
+    fp = frame[0];
+  }
+}
+
+// Take a sample of code interrupted by the clock at pc,
+// with frame pointer fp. Called by usertrap() and kerneltrap()
+// with interrupts off.
+void
+prof_tick(int user, uint64 pc, uint64 fp)
+{
+  struct profbuf *b;
+  struct prof_sample *s;
+  struct proc *p;
+  int id;
+
+  if(!prof_on)
+    return;
+
+  id = cpuid();
+  b = &profbufs[id];
+  s = cpuring_slot(&b->ring, b->s, NPROF, sizeof(*s));
+  p = myproc();
+  s->pid = p ? p->pid : 0;
+  s->cpu = id;
+  s->user = user;
+  safestrcpy(s->name, p ? p->name : "", sizeof(s->name));
+  s->pc[0] = pc;
+  s->depth = 1;
+  walk_stack(s, user, fp);
+  cpuring_push(&b->ring);
+}
+
+// Turn sampling on or off.
+// Returns whether it was on.
+int
+prof_ctl(int on)
+{
+  int old = prof_on;
+
+  prof_on = on != 0;
+  return old;
+}
+
+// Copy up to n samples not yet drained to user address buf,
+// CPU by CPU. Samples overwritten before they were drained are
+// lost. Returns how many were copied.
+int
+prof_read(uint64 buf, int n)
+{
+  struct profbuf *b;
+  int cnt = 0, got;
+
+  acquire(&prof_lock);
+  for(b = profbufs; b < &profbufs[NCPU] && cnt < n; b++){
+    got = cpuring_read(&b->ring, b->s, NPROF, sizeof(b->s[0]),
+                       buf + cnt*sizeof(b->s[0]), n - cnt);
+    if(got < 0){
+      release(&prof_lock);
+      return -1;
+    }
+    cnt += got;
+  }
+  release(&prof_lock);
+  return cnt;
+}
@@ -0,0 +1,12 @@
+// sampling profiler records, as returned by prof_read().
+#define PROF_DEPTH 8    // pcs kept per sample
+
+struct prof_sample {
+  int pid;                  // 0 in the scheduler
+  ushort cpu;
+  ushort user;              // interrupted in user mode?
+  int depth;                // pcs in pc[]
+  int pad;
+  char name[16];            // the process's name, for its .sym file
+  uint64 pc[PROF_DEPTH];    // interrupted pc, then return addresses
+};
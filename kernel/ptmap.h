@@ -0,0 +1,8 @@
+// a run of pages mapped alike, as returned by ps_pt_walk().
+struct pt_map {
+  uint64 va;      // first virtual address
+  uint64 len;     // bytes
+  uint64 pa;      // physical address of va
+  uint flags;     // PTE_V, R, W, X, U and G; not accessed or dirty
+  int level;      // of the leaf PTEs: 0 for 4 KiB pages, 1 for 2 MiB, 2 for 1 GiB
+};
@@ -0,0 +1,105 @@
+// System call rings; see ring.h.
+//
+// ring_enter() runs each queued call through the normal system
+// call table, with the call's arguments put in the trapframe as
+// if the process had trapped with them, so one trap can carry
+// a whole batch of I/O.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "syscall.h"
+#include "ring.h"
+#include "defs.h"
+
+// the kernel address of p's ring, or 0 if it has none.
+static struct ring*
+ringof(struct proc *p)
+{
+  return (struct ring*)walkaddr(p->pagetable, RING);
+}
+
+// Give the calling process's address space a ring, if it has
+// none yet. Returns its user address, RING, or -1.
+// fork() children don't inherit the ring; exec() drops it.
+uint64
+ring_setup(void)
+{
+  struct proc *p = myproc();
+  struct ring *r;
+  int mapped;
+
+  if((r = (struct ring*)kalloc()) == 0)
+    return -1;
+  memset(r, 0, PGSIZE);
+  // another thread may have given the address space one first.
+  mapped = proc_mappage(p, RING, (uint64)r, PTE_R | PTE_W | PTE_U);
+  if(mapped != 1)
+    kfree((void*)r);
+  return mapped < 0 ? -1 : RING;
+}
+
+static int
+ring_allowed(int op)
+{
+  return op == SYS_read || op == SYS_write || op == SYS_open ||
+         op == SYS_close || op == SYS_ps_info;
+}
+
+// Run up to n queued system calls, stopping early if the
+// completion queue fills up. Returns how many ran, or -1 if
+// the process has no ring. Only one thread should submit to
+// a ring at a time.
+int
+ring_enter(int n)
+{
+  struct proc *p = myproc();
+  struct trapframe *tf = p->trapframe;
+  struct ring *r;
+  struct ring_sqe e;
+  struct ring_cqe *c;
+  uint64 a0, a1, a2;
+  uint head, tail;
+  int done;
+
+  if((r = ringof(p)) == 0)
+    return -1;
+
+  a0 = tf->a0;
+  a1 = tf->a1;
+  a2 = tf->a2;
+  for(done = 0; done < n && !killed(p); done++){
+    head = r->sq_head;
+    if(head == r->sq_tail)
+      break;
+    tail = r->cq_tail;
+    if(tail - r->cq_head >= RING_SIZE)
+      break;
+    __sync_synchronize();  // read the entry after sq_tail
+
+    // copy it: the process may change it under us.
+    e = r->sq[head % RING_SIZE];
+    c = &r->cq[tail % RING_SIZE];
+    c->user_data = e.user_data;
+    if(ring_allowed(e.op)){
+      tf->a0 = e.args[0];
+      tf->a1 = e.args[1];
+      tf->a2 = e.args[2];
+      c->res = syscall_run(e.op);
+    } else {
+      c->res = -1;
+    }
+
+    __sync_synchronize();  // publish the result before cq_tail
+    r->cq_tail = tail + 1;
+    r->sq_head = head + 1;
+  }
+  tf->a0 = a0;
+  tf->a1 = a1;
+  tf->a2 = a2;
+
+  return done;
+}
@@ -0,0 +1,33 @@
+// A submission/completion ring shared by a process and the
+// kernel, for issuing batches of system calls with a single
+// ring_enter(). ring_setup() maps it at RING in the process.
+//
+// The process fills sq[sq_tail % RING_SIZE] and then bumps
+// sq_tail; ring_enter() runs queued calls from sq_head on and
+// posts their results at cq_tail, for the process to consume
+// from cq_head. Each side only writes its own index.
+
+#define RING_SIZE 64  // entries per queue, a power of two
+
+// a queued system call: op is its SYS_ number. only read,
+// write, open, close and ps_info are allowed.
+struct ring_sqe {
+  int op;
+  int pad;
+  uint64 args[3];
+  uint64 user_data;   // passed back in the completion
+};
+
+struct ring_cqe {
+  uint64 user_data;
+  long res;           // the system call's return value
+};
+
+struct ring {
+  volatile uint sq_head;  // written by the kernel
+  volatile uint sq_tail;  // written by the process
+  volatile uint cq_head;  // written by the process
+  volatile uint cq_tail;  // written by the kernel
+  struct ring_sqe sq[RING_SIZE];
+  struct ring_cqe cq[RING_SIZE];
+};
@@ -9,11 +9,22 @@
 #include "defs.h"
 
 void
-initlock(struct spinlock *lk, char *name)
+initlock_kind(struct spinlock *lk, char *name, int kind)
 {
   lk->name = name;
   lk->locked = 0;
+  lk->kind = kind;
+  lk->next = 0;
+  lk->owner = 0;
   lk->cpu = 0;
+  lk->stat = 0;
+  lk->acquired = 0;
+}
+
+void
+initlock(struct spinlock *lk, char *name)
+{
+  initlock_kind(lk, name, SPIN_TAS);
 }
 
 // Acquire the lock.
@@ -21,16 +32,45 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  int counted = LOCKSTAT && lockstat_on;
+  uint64 start = 0;
+  int spun = 0;
+
   push_off(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
-  // On RISC-V, sync_lock_test_and_set turns into an atomic swap:
-  //   a5 = 1
-  //   s1 = &lk->locked
-  //   amoswap.w.aq a5, a5, (s1)
-  while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
-    ;
+  if(counted)
+    start = r_time();
+
+  // Interrupts are off, so keep serving TLB shootdowns while
+  // spinning, in case the holder is waiting for us to flush.
+  if(lk->kind == SPIN_TICKET){
+    // take the next ticket and wait for it to be served. waiters
+    // only read lk->owner while they spin, so the cache line is
+    // not bounced between them, and they get the lock in order.
+    uint t = __sync_fetch_and_add(&lk->next, 1);
+    if(*(volatile uint*)&lk->owner != t){
+      struct cpu *c = mycpu();
+      c->spinning = lk;  // so ps can tell who waits for whom
+      while(*(volatile uint*)&lk->owner != t)
+        tlb_flush();
+      c->spinning = 0;
+      spun = 1;
+    }
+    lk->locked = 1;  // for holding()
+  } else if(__sync_lock_test_and_set(&lk->locked, 1) != 0){
+    // On RISC-V, sync_lock_test_and_set turns into an atomic swap:
+    //   a5 = 1
+    //   s1 = &lk->locked
+    //   amoswap.w.aq a5, a5, (s1)
+    struct cpu *c = mycpu();
+    c->spinning = lk;
+    while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
+      tlb_flush();
+    c->spinning = 0;
+    spun = 1;
+  }
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -40,6 +80,9 @@ acquire(struct spinlock *lk)
 
   // Record info about lock acquisition for holding() and debugging.
   lk->cpu = mycpu();
+
+  if(counted)
+    lockstat_acquired(lk, start, r_time(), spun);
 }
 
 // Release the lock.
@@ -49,6 +92,9 @@ release(struct spinlock *lk)
   if(!holding(lk))
     panic("release");
 
+  if(LOCKSTAT && lk->acquired)
+    lockstat_released(lk);
+
   lk->cpu = 0;
 
   // Tell the C compiler and the CPU to not move loads or stores
@@ -68,6 +114,11 @@ release(struct spinlock *lk)
   //   amoswap.w zero, zero, (s1)
   __sync_lock_release(&lk->locked);
 
+  // serve the next ticket. a full barrier, so the next holder
+  // cannot set lk->locked before it was cleared above.
+  if(lk->kind == SPIN_TICKET)
+    __sync_fetch_and_add(&lk->owner, 1);
+
   pop_off();
 }
 
@@ -1,9 +1,20 @@
+// kinds of spinlock, chosen per lock in initlock_kind().
+#define SPIN_TAS     0   // test-and-set: cheap, but unfair under contention
+#define SPIN_TICKET  1   // ticket: served in arrival order
+
 // Mutual exclusion lock.
 struct spinlock {
   uint locked;       // Is the lock held?
+  int kind;          // SPIN_*
+  uint next;         // SPIN_TICKET: next ticket to hand out
+  uint owner;        // SPIN_TICKET: ticket being served
 
   // For debugging:
   char *name;        // Name of lock.
   struct cpu *cpu;   // The cpu holding the lock.
+
+  // For lockstat.c:
+  int stat;          // slot of its name + 1, 0 if not looked up yet
+  uint64 acquired;   // time CSR when acquired, 0 if not counted
 };
 
@@ -11,7 +11,7 @@ void timerinit();
 __attribute__ ((aligned (16))) char stack0[4096 * NCPU];
 
 // a scratch area per CPU for machine-mode timer interrupts.
-uint64 timer_scratch[NCPU][5];
+uint64 timer_scratch[NCPU][7];
 
 // assembly code in kernelvec.S for machine-mode timer interrupt.
 extern void timervec();
@@ -46,6 +46,9 @@ start()
   // ask for clock interrupts.
   timerinit();
 
+  // let supervisor mode read the time CSR, for CPU accounting.
+  w_mcounteren(r_mcounteren() | 2);
+
   // keep each CPU's hartid in its tp register, for cpuid().
   int id = r_mhartid();
   w_tp(id);
@@ -65,17 +68,23 @@ timerinit()
   // each CPU has a separate source of timer interrupts.
   int id = r_mhartid();
 
-  // ask the CLINT for a timer interrupt.
-  int interval = 1000000; // cycles; about 1/10th second in qemu.
+  // ask the CLINT for a timer interrupt. with TICKLESS it is
+  // one-shot: the kernel sets mtimecmp for the next one itself.
+  int interval = TICK_INTERVAL;
   *(uint64*)CLINT_MTIMECMP(id) = *(uint64*)CLINT_MTIME + interval;
 
   // prepare information in scratch[] for timervec.
   // scratch[0..2] : space for timervec to save registers.
   // scratch[3] : address of CLINT MTIMECMP register.
-  // scratch[4] : desired interval (in cycles) between timer interrupts.
+  // scratch[4] : desired interval (in cycles) between timer interrupts,
+  //              0 for one-shot.
+  // scratch[5] : set by timervec when it forwards a clock tick.
+  // scratch[6] : address of CLINT MSIP register, for IPIs.
   uint64 *scratch = &timer_scratch[id][0];
   scratch[3] = CLINT_MTIMECMP(id);
-  scratch[4] = interval;
+  scratch[4] = TICKLESS ? 0 : interval;
+  scratch[5] = 0;
+  scratch[6] = CLINT_MSIP(id);
   w_mscratch((uint64)scratch);
 
   // set the machine-mode trap handler.
@@ -84,6 +93,65 @@ timerinit()
   // enable machine-mode interrupts.
   w_mstatus(r_mstatus() | MSTATUS_MIE);
 
-  // enable machine-mode timer interrupts.
-  w_mie(r_mie() | MIE_MTIE);
+  // enable machine-mode timer interrupts, and software
+  // interrupts, which other harts raise to send IPIs.
+  w_mie(r_mie() | MIE_MTIE | MIE_MSIE);
+}
+
+// timervec turns both clock ticks and IPIs into supervisor
+// software interrupts. called by devintr() in supervisor
+// mode: was a clock tick forwarded since the last call?
+int
+timer_ticked(void)
+{
+  return __sync_lock_test_and_set(&timer_scratch[cpuid()][5], 0) != 0;
+}
+
+// with TICKLESS, ask for this hart's next clock interrupt at
+// time CSR value when, replacing any earlier request.
+// the CLINT is mapped in the kernel page table.
+void
+timer_set(uint64 when)
+{
+  *(uint64*)CLINT_MTIMECMP(cpuid()) = when;
+}
+
+// with TICKLESS, when the time slice of the process running on
+// each hart ends.
+static uint64 slice_end[NCPU];
+
+// ask for a clock interrupt at the end of the running process's
+// time slice, or the nearest deadline of a sleeping process if
+// that is sooner.
+static void
+timer_arm(void)
+{
+  uint64 end = slice_end[cpuid()];
+  uint64 next = timer_next();
+
+  timer_set(next < end ? next : end);
+}
+
+// start the running process's time slice, which ends at the
+// next tick boundary.
+void
+timer_slice(void)
+{
+  slice_end[cpuid()] = (r_time() / TICK_INTERVAL + 1) * TICK_INTERVAL;
+  timer_arm();
+}
+
+// after a clock interrupt on a hart running a process, ask for
+// the next one. returns 1 if the process's time slice is over,
+// starting another, or 0 if the interrupt only came for a
+// sleeping process's deadline.
+int
+timer_tick(void)
+{
+  if(r_time() < slice_end[cpuid()]){
+    timer_arm();
+    return 0;
+  }
+  timer_slice();
+  return 1;
 }
@@ -0,0 +1,10 @@
+// per-process system call trace records, as returned by trace_read().
+struct strace_rec {
+  uint64 seq;       // records logged before this one
+  int num;          // system call number
+  int pad;
+  uint64 args[6];   // a0..a5 on entry
+  uint64 ret;
+  uint64 start;     // time CSR on entry
+  uint64 cycles;    // time CSR cycles spent in the call
+};
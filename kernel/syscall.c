@@ -5,8 +5,15 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "syscall.h"
+#include "lathist.h"
+#include "sysstat.h"
+#include "trace.h"
 #include "defs.h"
 
+// per-CPU system call counters, so that counting takes no lock
+// and shares no cache lines between harts.
+struct syscall_stat sysstats[NCPU][NSYSSTAT];
+
 // Fetch the uint64 at addr from the current process.
 int
 fetchaddr(uint64 addr, uint64 *ip)
@@ -108,7 +115,31 @@ extern uint64 sys_ps_pt0(void);
 extern uint64 sys_ps_pt1(void);
 extern uint64 sys_ps_pt2(void);
 extern uint64 sys_ps_copy(void);
-extern uint64 sys_ps_sleep_write(void);
+extern uint64 sys_sched_setaffinity(void);
+extern uint64 sys_sched_getaffinity(void);
+extern uint64 sys_clone(void);
+extern uint64 sys_join(void);
+extern uint64 sys_futex(void);
+extern uint64 sys_ps_cpus(void);
+extern uint64 sys_nanosleep(void);
+extern uint64 sys_ring_setup(void);
+extern uint64 sys_ring_enter(void);
+extern uint64 sys_ps_syscalls(void);
+extern uint64 sys_ktrace_ctl(void);
+extern uint64 sys_ktrace_read(void);
+extern uint64 sys_prof_ctl(void);
+extern uint64 sys_prof_read(void);
+extern uint64 sys_trace(void);
+extern uint64 sys_trace_read(void);
+extern uint64 sys_ps_snapshot(void);
+extern uint64 sys_process_vm_readv(void);
+extern uint64 sys_process_vm_writev(void);
+extern uint64 sys_ps_pt_walk(void);
+extern uint64 sys_ps_blocked(void);
+extern uint64 sys_ps_faults(void);
+extern uint64 sys_lockstat_ctl(void);
+extern uint64 sys_lockstat_read(void);
+extern uint64 sys_lockbench(void);
 
 // An array mapping syscall numbers from syscall.h
 // to the function that handles the system call.
@@ -141,9 +172,79 @@ static uint64 (*syscalls[])(void) = {
 [SYS_ps_pt1]  sys_ps_pt1,
 [SYS_ps_pt2]  sys_ps_pt2,
 [SYS_ps_copy] sys_ps_copy,
-[SYS_ps_sleep_write] sys_ps_sleep_write,
+[SYS_sched_setaffinity] sys_sched_setaffinity,
+[SYS_sched_getaffinity] sys_sched_getaffinity,
+[SYS_clone]   sys_clone,
+[SYS_join]    sys_join,
+[SYS_futex]   sys_futex,
+[SYS_ps_cpus] sys_ps_cpus,
+[SYS_nanosleep] sys_nanosleep,
+[SYS_ring_setup] sys_ring_setup,
+[SYS_ring_enter] sys_ring_enter,
+[SYS_ps_syscalls] sys_ps_syscalls,
+[SYS_ktrace_ctl] sys_ktrace_ctl,
+[SYS_ktrace_read] sys_ktrace_read,
+[SYS_prof_ctl] sys_prof_ctl,
+[SYS_prof_read] sys_prof_read,
+[SYS_trace]   sys_trace,
+[SYS_trace_read] sys_trace_read,
+[SYS_ps_snapshot] sys_ps_snapshot,
+[SYS_process_vm_readv] sys_process_vm_readv,
+[SYS_process_vm_writev] sys_process_vm_writev,
+[SYS_ps_pt_walk] sys_ps_pt_walk,
+[SYS_ps_blocked] sys_ps_blocked,
+[SYS_ps_faults] sys_ps_faults,
+[SYS_lockstat_ctl] sys_lockstat_ctl,
+[SYS_lockstat_read] sys_lockstat_read,
+[SYS_lockbench] sys_lockbench,
 };
 
+// Run system call num, with its arguments in p->trapframe as
+// if the process had made it; for ring.c's queued calls.
+// Returns -1 for an unknown num.
+uint64
+syscall_run(int num)
+{
+  if(num > 0 && num < NELEM(syscalls) && syscalls[num])
+    return syscalls[num]();
+  return -1;
+}
+
+// count a call to num that took cycles and returned ret.
+static void
+syscall_count(int num, uint64 cycles, uint64 ret)
+{
+  struct syscall_stat *s;
+
+  if(num >= NSYSSTAT)
+    return;
+
+  // the process may have moved CPU while in the call;
+  // count on the one we are on now.
+  push_off();
+  s = &sysstats[cpuid()][num];
+  s->calls++;
+  if((long)ret < 0)
+    s->errors++;
+  lathist_add(&s->lat, cycles);
+  pop_off();
+}
+
+// Sum system call num's counters over all CPUs into *s.
+void
+syscall_stat_sum(int num, struct syscall_stat *s)
+{
+  memset(s, 0, sizeof(*s));
+  if(num < 0 || num >= NSYSSTAT)
+    return;
+  for(int i = 0; i < NCPU; i++){
+    struct syscall_stat *c = &sysstats[i][num];
+    s->calls += c->calls;
+    s->errors += c->errors;
+    lathist_sum(&s->lat, &c->lat);
+  }
+}
+
 void
 syscall(void)
 {
@@ -154,7 +255,20 @@ syscall(void)
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
     // Use num to lookup the system call function for num, call it,
     // and store its return value in p->trapframe->a0
+    uint64 start = r_time();
+    uint64 args[6];
+    // tracemask may change under us; decide once.
+    int traced = num < 64 && (p->tracemask & (1L << num));
+    if(traced)
+      memmove(args, &p->trapframe->a0, sizeof(args));
+    trace(TR_SYSCALL, num);
     p->trapframe->a0 = syscalls[num]();
+    trace(TR_SYSRET, p->trapframe->a0);
+    uint64 cycles = r_time() - start;
+    syscall_count(num, cycles, p->trapframe->a0);
+    p->syscalls++;
+    if(traced)
+      strace_log(num, args, start, cycles, p->trapframe->a0);
   } else {
     printf("%d %s: unknown sys call %d\n",
             p->pid, p->name, num);
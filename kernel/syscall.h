@@ -28,4 +28,28 @@
 #define SYS_ps_pt1  26
 #define SYS_ps_pt2  27
 #define SYS_ps_copy 28
-#define SYS_ps_sleep_write 29
+#define SYS_sched_setaffinity 30
+#define SYS_sched_getaffinity 31
+#define SYS_clone   32
+#define SYS_join    33
+#define SYS_futex   34
+#define SYS_ps_cpus 35
+#define SYS_nanosleep 36
+#define SYS_ring_setup 37
+#define SYS_ring_enter 38
+#define SYS_ps_syscalls 39
+#define SYS_ktrace_ctl 40
+#define SYS_ktrace_read 41
+#define SYS_prof_ctl 42
+#define SYS_prof_read 43
+#define SYS_trace   44
+#define SYS_trace_read 45
+#define SYS_ps_snapshot 46
+#define SYS_process_vm_readv 47
+#define SYS_process_vm_writev 48
+#define SYS_ps_pt_walk 49
+#define SYS_ps_blocked 50
+#define SYS_ps_faults 51
+#define SYS_lockstat_ctl 52
+#define SYS_lockstat_read 53
+#define SYS_lockbench 54
@@ -98,6 +98,21 @@ sys_ps_info(void) {
   return handle_ps_info(pid, psinfo);
 }
 
+uint64
+sys_ps_snapshot(void) {  // struct process_info* buf, int n, uint64* gen
+
+  uint64 buf;  // user pointer to struct process_info array
+  argaddr(0, &buf);
+
+  int n;
+  argint(1, &n);
+
+  uint64 gen;  // user pointer, may be 0
+  argaddr(2, &gen);
+
+  return handle_ps_snapshot(buf, n, gen);
+}
+
 uint64
 sys_ps_pt0(void) { // int pid, uint64* table
 
@@ -140,6 +155,22 @@ sys_ps_pt2(void) {  // int pid, uint64* table, void* address
   return handle_ps_pt2(pid, table, address);
 }
 
+uint64
+sys_ps_pt_walk(void) {  // int pid, struct pt_map* buf, int n
+
+    int pid;
+    argint(0, &pid);
+
+    uint64 buf;  // user pointer to struct pt_map array
+    argaddr(1, &buf);
+
+    int n;
+    argint(2, &n);
+
+    return handle_ps_pt_walk(pid, buf, n);
+
+}
+
 uint64
 sys_ps_copy(void) {  // int pid, void* addr, int size, void* data)
     
@@ -160,15 +191,85 @@ sys_ps_copy(void) {  // int pid, void* addr, int size, void* data)
 }
 
 uint64
-sys_ps_sleep_write(void) {  // int pid, void* addr
+sys_process_vm_readv(void) {  // int pid, struct iovec* local, int liovcnt, struct iovec* remote, int riovcnt
 
     int pid;
     argint(0, &pid);
-    
-    uint64 addr;
-    argaddr(1, &addr);
-    
-    return handle_ps_sleep_write(pid, addr);
+
+    uint64 liov;  // user pointer to the caller's struct iovec array
+    argaddr(1, &liov);
+
+    int liovcnt;
+    argint(2, &liovcnt);
+
+    uint64 riov;  // user pointer to struct iovec array of pid's buffers
+    argaddr(3, &riov);
+
+    int riovcnt;
+    argint(4, &riovcnt);
+
+    return handle_process_vm(pid, liov, liovcnt, riov, riovcnt, 0);
+
+}
+
+uint64
+sys_process_vm_writev(void) {  // int pid, struct iovec* local, int liovcnt, struct iovec* remote, int riovcnt
+
+    int pid;
+    argint(0, &pid);
+
+    uint64 liov;  // user pointer to the caller's struct iovec array
+    argaddr(1, &liov);
+
+    int liovcnt;
+    argint(2, &liovcnt);
+
+    uint64 riov;  // user pointer to struct iovec array of pid's buffers
+    argaddr(3, &riov);
+
+    int riovcnt;
+    argint(4, &riovcnt);
+
+    return handle_process_vm(pid, liov, liovcnt, riov, riovcnt, 1);
+
+}
+
+uint64
+sys_sched_setaffinity(void) {  // int pid, uint mask
+
+    int pid;
+    argint(0, &pid);
+
+    int mask;
+    argint(1, &mask);
+
+    return handle_sched_setaffinity(pid, mask);
+
+}
+
+uint64
+sys_sched_getaffinity(void) {  // int pid, uint* mask
+
+    int pid;
+    argint(0, &pid);
+
+    uint64 mask;  // user pointer to uint
+    argaddr(1, &mask);
+
+    return handle_sched_getaffinity(pid, mask);
+
+}
+
+uint64
+sys_ps_cpus(void) {  // struct cpu_info* buf, int n
+
+    uint64 buf;  // user pointer to struct cpu_info array
+    argaddr(0, &buf);
+
+    int n;
+    argint(1, &n);
+
+    return handle_ps_cpus(buf, n);
 
 }
 
@@ -614,3 +715,167 @@ sys_pipe(void)
   }
   return 0;
 }
+
+uint64
+sys_ps_syscalls(void) {  // struct syscall_stat* buf, int n
+
+    uint64 buf;  // user pointer to struct syscall_stat array
+    argaddr(0, &buf);
+
+    int n;
+    argint(1, &n);
+
+    return handle_ps_syscalls(buf, n);
+
+}
+
+uint64
+sys_ps_blocked(void) {  // struct blocked_info* buf, int n
+
+    uint64 buf;  // user pointer to struct blocked_info array
+    argaddr(0, &buf);
+
+    int n;
+    argint(1, &n);
+
+    return handle_ps_blocked(buf, n);
+
+}
+
+uint64
+sys_ps_faults(void) {  // struct fault_stat* buf
+
+    uint64 buf;  // user pointer to struct fault_stat
+    argaddr(0, &buf);
+
+    return handle_ps_faults(buf);
+
+}
+
+uint64
+sys_ktrace_ctl(void) {  // int mask
+
+    int mask;  // TR_* events to record, a bit each
+    argint(0, &mask);
+
+    return ktrace_ctl(mask);
+
+}
+
+uint64
+sys_ktrace_read(void) {  // struct trace_rec* buf, int n
+
+    uint64 buf;  // user pointer to struct trace_rec array
+    argaddr(0, &buf);
+
+    int n;
+    argint(1, &n);
+
+    return ktrace_read(buf, n);
+
+}
+
+uint64
+sys_prof_ctl(void) {  // int on
+
+    int on;  // sample on clock interrupts?
+    argint(0, &on);
+
+    return prof_ctl(on);
+
+}
+
+uint64
+sys_prof_read(void) {  // struct prof_sample* buf, int n
+
+    uint64 buf;  // user pointer to struct prof_sample array
+    argaddr(0, &buf);
+
+    int n;
+    argint(1, &n);
+
+    return prof_read(buf, n);
+
+}
+
+uint64
+sys_lockstat_ctl(void) {  // int on
+
+    int on;  // count from zero, or stop counting
+    argint(0, &on);
+
+    return lockstat_ctl(on);
+
+}
+
+uint64
+sys_lockstat_read(void) {  // struct lock_stat* buf, int n
+
+    uint64 buf;  // user pointer to struct lock_stat array
+    argaddr(0, &buf);
+
+    int n;
+    argint(1, &n);
+
+    return lockstat_read(buf, n);
+
+}
+
+uint64
+sys_lockbench(void) {  // int kind, int ms
+
+    int kind;  // SPIN_* of the lock to hammer
+    argint(0, &kind);
+
+    int ms;  // for how long
+    argint(1, &ms);
+
+    return lockbench(kind, ms);
+
+}
+
+uint64
+sys_trace(void) {  // int pid, uint64 mask
+
+    int pid;  // 0 for the calling process
+    argint(0, &pid);
+
+    uint64 mask;  // system calls to log, a bit per number
+    argaddr(1, &mask);
+
+    return handle_trace(pid, mask);
+
+}
+
+uint64
+sys_trace_read(void) {  // int pid, struct strace_rec* buf, int n
+
+    int pid;
+    argint(0, &pid);
+
+    uint64 buf;  // user pointer to struct strace_rec array
+    argaddr(1, &buf);
+
+    int n;
+    argint(2, &n);
+
+    return handle_trace_read(pid, buf, n);
+
+}
+
+uint64
+sys_ring_setup(void) {
+
+    return ring_setup();
+
+}
+
+uint64
+sys_ring_enter(void) {  // int n
+
+    int n;  // how many queued calls to run at most
+    argint(0, &n);
+
+    return ring_enter(n);
+
+}
@@ -35,6 +35,39 @@ sys_wait(void)
   return wait(p);
 }
 
+uint64
+sys_clone(void)
+{
+  uint64 fn, arg1, arg2, stack;
+
+  argaddr(0, &fn);
+  argaddr(1, &arg1);
+  argaddr(2, &arg2);
+  argaddr(3, &stack);
+  return clone(fn, arg1, arg2, stack);
+}
+
+uint64
+sys_join(void)
+{
+  int tid;
+
+  argint(0, &tid);
+  return join(tid);
+}
+
+uint64
+sys_futex(void)
+{
+  uint64 addr;
+  int op, val;
+
+  argaddr(0, &addr);
+  argint(1, &op);
+  argint(2, &val);
+  return futex(addr, op, val);
+}
+
 uint64
 sys_sbrk(void)
 {
@@ -42,8 +75,7 @@ sys_sbrk(void)
   int n;
 
   argint(0, &n);
-  addr = myproc()->sz;
-  if(growproc(n) < 0)
+  if(growproc(n, &addr) < 0)
     return -1;
   return addr;
 }
@@ -52,20 +84,27 @@ uint64
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
 
   argint(0, &n);
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(killed(myproc())){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  if(n < 0)
+    n = 0;
+  return timer_sleep(r_time() + (uint64)n * TICK_INTERVAL);
+}
+
+// sleep for at least ns nanoseconds.
+uint64
+sys_nanosleep(void)
+{
+  uint64 ns;
+
+  argaddr(0, &ns);
+  // round up to whole time CSR cycles, dividing first so that
+  // no ns overflows; a deadline past the end of time saturates.
+  uint64 cycles = ns / 1000 * (TIMEBASE / 1000000) +
+                  (ns % 1000 * (TIMEBASE / 1000000) + 999) / 1000;
+  uint64 now = r_time();
+  uint64 deadline = now + cycles < now ? ~0ULL : now + cycles;
+  return timer_sleep(deadline);
 }
 
 uint64
@@ -85,6 +124,7 @@ sys_uptime(void)
   uint xticks;
 
   acquire(&tickslock);
+  ticksync();
   xticks = ticks;
   release(&tickslock);
   return xticks;
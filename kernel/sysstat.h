@@ -0,0 +1,8 @@
+#define NSYSSTAT   64  // system call numbers counted, 0..NSYSSTAT-1
+
+// counters for one system call.
+struct syscall_stat {
+  uint64 calls;
+  uint64 errors;            // returned a negative value
+  struct lathist lat;       // time spent in it, see lathist.h
+};
@@ -0,0 +1,226 @@
+// Timer wheel for sleeping until a deadline.
+//
+// Each process has one struct timer, queued while it sleeps in
+// timer_sleep(). Deadlines are time CSR values, kept in a
+// hierarchical wheel whose unit is 2^WHEEL_SHIFT cycles: level 0
+// has a slot per unit for the next 64 units, level 1 a slot per
+// 64 units for the next 64*64, and so on. clockintr() calls
+// timer_run(), which walks the units that have passed, moving
+// timers down a level as their slot comes up and waking those
+// that have expired, so sleepers are only woken when their own
+// deadline has come.
+//
+// With TICKLESS, harts also ask for a clock interrupt at the
+// earliest deadline (timer_next()), so timers are not limited
+// to tick resolution.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+
+#define WHEEL_SHIFT 10               // a unit is 1024 cycles, about 100us
+#define LVL_BITS    6
+#define LVL_SIZE    (1 << LVL_BITS)
+#define NLVL        4
+#define MAXDELTA    ((1L << (LVL_BITS*NLVL)) - 1)
+
+struct {
+  struct spinlock lock;
+  uint64 clk;                        // last unit processed
+  struct timer *slot[NLVL][LVL_SIZE];
+  int n[NLVL];                       // timers queued per level
+  uint64 next;                       // earliest deadline, -1 if none
+} wheel;
+
+void
+wheelinit(void)
+{
+  initlock(&wheel.lock, "wheel");
+  wheel.clk = r_time() >> WHEEL_SHIFT;
+  wheel.next = -1;
+}
+
+// queue t in the slot for its deadline, or for unit first,
+// the earliest one still to be run, if that is later.
+// wheel.lock must be held.
+static void
+enqueue(struct timer *t, uint64 first)
+{
+  uint64 u = t->expires >> WHEEL_SHIFT;
+  uint64 delta;
+  int l;
+
+  if(u < first)
+    u = first;
+  delta = u - wheel.clk;
+  if(delta > MAXDELTA)
+    u = wheel.clk + MAXDELTA;  // comes back round when cascaded
+
+  for(l = 0; l < NLVL - 1; l++)
+    if(delta < (1L << (LVL_BITS*(l+1))))
+      break;
+
+  struct timer **head = &wheel.slot[l][(u >> (LVL_BITS*l)) & (LVL_SIZE-1)];
+  t->level = l;
+  t->next = *head;
+  t->pprev = head;
+  if(*head)
+    (*head)->pprev = &t->next;
+  *head = t;
+  wheel.n[l]++;
+}
+
+// wheel.lock must be held.
+static void
+dequeue(struct timer *t)
+{
+  *t->pprev = t->next;
+  if(t->next)
+    t->next->pprev = t->pprev;
+  t->next = 0;
+  t->pprev = 0;
+  wheel.n[t->level]--;
+}
+
+// when timer_run() will find t expired: not before the unit
+// after the last one processed.
+// wheel.lock must be held.
+static uint64
+fires(struct timer *t)
+{
+  uint64 first = (wheel.clk + 1) << WHEEL_SHIFT;
+
+  return t->expires > first ? t->expires : first;
+}
+
+// wheel.lock must be held.
+static void
+timer_add(struct timer *t, uint64 expires)
+{
+  t->expires = expires;
+  t->pending = 1;
+  enqueue(t, wheel.clk + 1);
+  if(fires(t) < wheel.next)
+    wheel.next = fires(t);
+}
+
+// wheel.lock must be held.
+static void
+timer_del(struct timer *t)
+{
+  if(!t->pending)
+    return;
+  dequeue(t);
+  t->pending = 0;
+}
+
+// empty level l's slot i, queueing its timers again lower
+// down. the current unit's level 0 slot has yet to be run.
+static void
+cascade(int l, int i)
+{
+  struct timer *t;
+
+  while((t = wheel.slot[l][i]) != 0){
+    dequeue(t);
+    enqueue(t, wheel.clk);
+  }
+}
+
+// Process the wheel up to now: wake the sleepers whose
+// deadline has passed. Called by clockintr().
+void
+timer_run(void)
+{
+  uint64 now = r_time();
+  uint64 target = now >> WHEEL_SHIFT;
+  struct timer *t;
+  int l;
+
+  acquire(&wheel.lock);
+  while(wheel.clk < target){
+    // nothing happens until the lowest level holding timers
+    // next cascades: skip there.
+    for(l = 0; l < NLVL && wheel.n[l] == 0; l++)
+      ;
+    if(l == NLVL){
+      wheel.clk = target;
+      break;
+    }
+    uint64 m = 1L << (LVL_BITS*l);
+    uint64 c = (wheel.clk + m) & ~(m - 1);
+    if(c > target){
+      wheel.clk = target;
+      break;
+    }
+    wheel.clk = c;
+
+    // each level's slots come up as the one below wraps.
+    for(l = 1; l < NLVL; l++){
+      uint64 i = (c >> (LVL_BITS*l)) & (LVL_SIZE-1);
+      if((c & ((1L << (LVL_BITS*l)) - 1)) != 0)
+        break;
+      cascade(l, i);
+    }
+
+    while((t = wheel.slot[0][c & (LVL_SIZE-1)]) != 0){
+      dequeue(t);
+      if(t->expires <= now){
+        t->pending = 0;
+        wakeup(t);
+      } else {
+        enqueue(t, c + 1);  // later in this unit
+      }
+    }
+  }
+
+  // find the new earliest deadline, if it has passed.
+  if(wheel.next <= now){
+    wheel.next = -1;
+    for(l = 0; l < NLVL; l++){
+      if(wheel.n[l] == 0)
+        continue;
+      for(int i = 0; i < LVL_SIZE; i++)
+        for(t = wheel.slot[l][i]; t; t = t->next)
+          if(fires(t) < wheel.next)
+            wheel.next = fires(t);
+    }
+  }
+  release(&wheel.lock);
+}
+
+// When the earliest deadline of a sleeping process will be
+// seen by timer_run(), -1 if none.
+uint64
+timer_next(void)
+{
+  return wheel.next;
+}
+
+// Sleep until the time CSR reaches deadline.
+// Returns 0, or -1 if killed.
+int
+timer_sleep(uint64 deadline)
+{
+  struct proc *p = myproc();
+  struct timer *t = &p->timer;
+  int r = 0;
+
+  acquire(&wheel.lock);
+  while(r_time() < deadline){
+    if(killed(p)){
+      r = -1;
+      break;
+    }
+    if(!t->pending)
+      timer_add(t, deadline);
+    sleep(t, &wheel.lock);
+  }
+  timer_del(t);
+  release(&wheel.lock);
+  return r;
+}
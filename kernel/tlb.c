@@ -0,0 +1,228 @@
+// Address space identifiers and TLB shootdown.
+//
+// satp tags the TLB entries of each user page table with its
+// ASID, so switching between processes needs no TLB flush:
+// other address spaces' entries stay cached, they just don't
+// match. The kernel page table has ASID 0.
+//
+// ASIDs are handed out in order, when a page table is first
+// switched to. Once they run out, a new generation starts: each
+// page table gets a new ASID when next switched to, and each
+// hart flushes its whole TLB once before using ASIDs of the new
+// generation. Within a generation an ASID is never reused, so a
+// page table can be freed without flushing anything.
+//
+// After a hart changes a user page table (uvmunmap(), uvmclear()),
+// other harts that used its ASID may still hold stale
+// translations. tlb_shootdown() queues the changed addresses in
+// each such hart's mailbox, sends it an IPI (its CLINT MSIP bit,
+// which timervec forwards as a supervisor software interrupt),
+// and waits until it has flushed.
+//
+// Requests queued to a hart are batched: it flushes everything
+// in its mailbox per interrupt, and the whole TLB once more than
+// NTLBBATCH addresses pile up.
+//
+// A hart waiting for a flush, or spinning in acquire(), has
+// interrupts off, so both keep serving their own mailbox;
+// otherwise two harts shooting at each other would deadlock.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+
+struct {
+  struct spinlock lock;
+  uint64 gen;               // current generation, from 1
+  uint next;                // next unused ASID of gen
+  uint max;                 // largest ASID satp holds, 0 if none
+} asids;
+
+struct mailbox {
+  uint lock;                // a bare flag: acquire() calls in here
+  int n;                    // addresses queued in va[]
+  int all;                  // flush the whole TLB instead
+  uint64 va[NTLBBATCH];
+  volatile uint64 req;      // requests queued so far
+  volatile uint64 done;     // requests flushed so far
+} mailbox[NCPU];
+
+static void
+mailbox_lock(struct mailbox *m)
+{
+  while(__sync_lock_test_and_set(&m->lock, 1) != 0)
+    ;
+  __sync_synchronize();
+}
+
+static void
+mailbox_unlock(struct mailbox *m)
+{
+  __sync_synchronize();
+  __sync_lock_release(&m->lock);
+}
+
+// Find out how many ASID bits the hart implements:
+// satp ignores writes to the others.
+void
+asidinit(void)
+{
+  uint64 satp;
+
+  initlock(&asids.lock, "asids");
+  asids.gen = 1;
+  asids.next = 1;
+  if(ASID){
+    satp = r_satp();
+    w_satp(satp | SATP_ASID(0xffff));
+    asids.max = SATP2ASID(r_satp());
+    w_satp(satp);
+    sfence_vma();
+  }
+}
+
+// The satp value that switches to pagetable, whose ASID is *a;
+// gives it a new ASID if it has none of the current generation.
+// Interrupts must be off.
+uint64
+asid_satp(pagetable_t pagetable, struct asid *a)
+{
+  struct cpu *c = mycpu();
+  uint bit = 1 << cpuid();
+  uint64 satp;
+
+  if(asids.max == 0)
+    return MAKE_SATP(pagetable);
+
+  // this hart used a's ASID before, in the current generation,
+  // so its TLB holds no other address space's entries for it.
+  if(a->gen == asids.gen && (a->cpumask & bit))
+    return MAKE_SATP(pagetable) | SATP_ASID(a->asid);
+
+  acquire(&asids.lock);
+  if(a->gen != asids.gen){
+    if(asids.next > asids.max){
+      asids.gen++;
+      asids.next = 1;
+    }
+    a->asid = asids.next++;
+    a->cpumask = 0;
+    __sync_synchronize();  // asid before gen, for the check above
+    a->gen = asids.gen;
+  }
+  if(c->asid_gen != asids.gen){
+    // drop the entries of the previous generation's ASIDs.
+    sfence_vma();
+    c->asid_gen = asids.gen;
+  }
+  a->cpumask |= bit;
+  satp = MAKE_SATP(pagetable) | SATP_ASID(a->asid);
+  release(&asids.lock);
+
+  return satp;
+}
+
+// Flush the TLB entries other harts have asked this one to.
+// Interrupts must be off.
+void
+tlb_flush(void)
+{
+  struct mailbox *m = &mailbox[cpuid()];
+  uint64 va[NTLBBATCH], req;
+  int i, n, all;
+
+  if(m->done == m->req)
+    return;
+
+  mailbox_lock(m);
+  req = m->req;
+  n = m->n;
+  all = m->all;
+  for(i = 0; i < n; i++)
+    va[i] = m->va[i];
+  m->n = 0;
+  m->all = 0;
+  mailbox_unlock(m);
+
+  if(all){
+    sfence_vma();
+  } else {
+    for(i = 0; i < n; i++)
+      sfence_vma_va(va[i]);
+  }
+  mycpu()->tlb_recv++;
+
+  __sync_synchronize();
+  m->done = req;
+}
+
+// Make every hart that may have cached pagetable's translations
+// drop its TLB entries for the npages starting at va, and wait
+// until they have. The page table changes must already be made.
+// Entries are dropped by address for all ASIDs, since a hart
+// still running pagetable may be using the ASID of an earlier
+// generation.
+void
+tlb_shootdown(pagetable_t pagetable, uint64 va, uint64 npages)
+{
+  uint64 want[NCPU];
+  struct mailbox *m;
+  struct asid *a;
+  struct proc *p;
+  uint used;
+  int i, id;
+
+  push_off();
+  id = cpuid();
+
+  if(npages > NTLBBATCH){
+    sfence_vma();
+  } else {
+    for(uint64 k = 0; k < npages; k++)
+      sfence_vma_va(va + k*PGSIZE);
+  }
+
+  // make the PTE changes visible before looking for users:
+  // a hart that starts using pagetable's ASID after this point
+  // walks the changed page table.
+  __sync_synchronize();
+
+  // a freed page table's ASID is never switched to again.
+  a = pagetable_asid(pagetable);
+  used = 0;
+  if(a && a->gen == asids.gen)
+    used = a->cpumask;
+
+  for(i = 0; i < NCPU; i++){
+    want[i] = 0;
+    p = cpus[i].proc;
+    if(i == id)
+      continue;
+    if((used & (1 << i)) == 0 && (p == 0 || p->pagetable != pagetable))
+      continue;
+
+    m = &mailbox[i];
+    mailbox_lock(m);
+    if(m->all || m->n + npages > NTLBBATCH){
+      m->all = 1;
+    } else {
+      for(uint64 k = 0; k < npages; k++)
+        m->va[m->n++] = va + k*PGSIZE;
+    }
+    want[i] = ++m->req;
+    mailbox_unlock(m);
+
+    *(uint32*)CLINT_MSIP(i) = 1;
+    mycpu()->tlb_sent++;
+  }
+
+  for(i = 0; i < NCPU; i++)
+    while(mailbox[i].done < want[i])
+      tlb_flush();
+
+  pop_off();
+}
@@ -0,0 +1,95 @@
+// Kernel tracepoints.
+//
+// trace() appends a record to a ring buffer of the current CPU:
+// a timestamp and a few stores, with interrupts off but no lock,
+// so the events can stay enabled. each buffer has one writer,
+// its CPU; ktrace_read() drains all of them, taking care of
+// records overwritten while it copies. see cpuring.c.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "trace.h"
+#include "cpuring.h"
+#include "defs.h"
+
+#define NTRACE 512  // records per CPU, a power of two
+
+struct tracebuf {
+  struct cpuring ring;
+  struct trace_rec rec[NTRACE];
+} tracebufs[NCPU];
+
+// events being recorded, a bit per TR_*.
+volatile int trace_mask = TR_ALL;
+
+// serializes readers.
+struct spinlock trace_lock;
+
+void
+traceinit(void)
+{
+  initlock(&trace_lock, "trace");
+}
+
+void
+trace(int event, uint64 arg)
+{
+  struct tracebuf *t;
+  struct trace_rec *r;
+  struct proc *p;
+  int id;
+
+  if((trace_mask & (1 << event)) == 0)
+    return;
+
+  push_off();
+  id = cpuid();
+  t = &tracebufs[id];
+  r = cpuring_slot(&t->ring, t->rec, NTRACE, sizeof(*r));
+  r->time = r_time();
+  r->event = event;
+  r->cpu = id;
+  p = cpus[id].proc;
+  r->pid = p ? p->pid : 0;
+  r->arg = arg;
+  cpuring_push(&t->ring);
+  pop_off();
+}
+
+// Record the events in mask from now on.
+// Returns the previous mask.
+int
+ktrace_ctl(int mask)
+{
+  int old = trace_mask;
+
+  trace_mask = mask & TR_ALL;
+  return old;
+}
+
+// Copy up to n records not yet drained to user address buf,
+// CPU by CPU, each CPU's in order. Records overwritten before
+// they were drained are lost. Returns how many were copied.
+int
+ktrace_read(uint64 buf, int n)
+{
+  struct tracebuf *t;
+  int cnt = 0, got;
+
+  acquire(&trace_lock);
+  for(t = tracebufs; t < &tracebufs[NCPU] && cnt < n; t++){
+    got = cpuring_read(&t->ring, t->rec, NTRACE, sizeof(t->rec[0]),
+                       buf + cnt*sizeof(t->rec[0]), n - cnt);
+    if(got < 0){
+      release(&trace_lock);
+      return -1;
+    }
+    cnt += got;
+  }
+  release(&trace_lock);
+  return cnt;
+}
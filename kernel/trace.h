@@ -0,0 +1,24 @@
+// kernel tracepoint events, as numbered in struct trace_rec.
+#define TR_SWITCH       1   // scheduler switches to pid arg
+#define TR_SLEEP        2   // arg: the channel
+#define TR_WAKEUP       3   // woke up pid arg
+#define TR_BREAD        4   // arg: dev << 32 | blockno
+#define TR_BWRITE       5   // arg: dev << 32 | blockno
+#define TR_DISK_SUBMIT  6   // arg: blockno << 1 | write
+#define TR_DISK_DONE    7   // arg: blockno
+#define TR_KALLOC       8   // arg: the page
+#define TR_KFREE        9   // arg: the page
+#define TR_SYSCALL     10   // arg: the system call number
+#define TR_SYSRET      11   // arg: its return value
+#define TR_FAULT       12   // arg: the page | FAULT_* kind
+#define NTREVENT       13
+
+#define TR_ALL ((1 << NTREVENT) - 2)
+
+struct trace_rec {
+  uint64 time;    // time CSR
+  ushort event;   // TR_*
+  ushort cpu;
+  int pid;        // running process, 0 in the scheduler
+  uint64 arg;
+};
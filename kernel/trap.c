@@ -27,6 +27,9 @@ void
 trapinithart(void)
 {
   w_stvec((uint64)kernelvec);
+
+  // let user code read the time CSR, for ulib's uptime().
+  w_scounteren(r_scounteren() | 2);
 }
 
 //
@@ -46,6 +49,11 @@ usertrap(void)
   w_stvec((uint64)kernelvec);
 
   struct proc *p = myproc();
+
+  // the time since usertrapret() was spent in user mode.
+  uint64 now = r_time();
+  p->utime += now - p->acct_start;
+  p->acct_start = now;
   
   // save user program counter.
   p->trapframe->epc = r_sepc();
@@ -65,6 +73,9 @@ usertrap(void)
     intr_on();
 
     syscall();
+  } else if((r_scause() == 12 || r_scause() == 13 || r_scause() == 15) &&
+            pagefault(r_scause(), r_stval()) == 0){
+    // ok
   } else if((which_dev = devintr()) != 0){
     // ok
   } else {
@@ -73,6 +84,9 @@ usertrap(void)
     setkilled(p);
   }
 
+  if(which_dev == 2)
+    prof_tick(1, p->trapframe->epc, p->trapframe->s0);
+
   if(killed(p))
     exit(-1);
 
@@ -119,14 +133,20 @@ usertrapret(void)
   // set S Exception Program Counter to the saved user pc.
   w_sepc(p->trapframe->epc);
 
+  // the time since usertrap() or scheduler() was spent
+  // in the kernel.
+  uint64 now = r_time();
+  p->stime += now - p->acct_start;
+  p->acct_start = now;
+
   // tell trampoline.S the user page table to switch to.
-  uint64 satp = MAKE_SATP(p->pagetable);
+  uint64 satp = asid_satp(p->pagetable, p->asid);
 
   // jump to userret in trampoline.S at the top of memory, which 
   // switches to the user page table, restores user registers,
   // and switches to user mode with sret.
   uint64 trampoline_userret = TRAMPOLINE + (userret - trampoline);
-  ((void (*)(uint64))trampoline_userret)(satp);
+  ((void (*)(uint64, uint64))trampoline_userret)(satp, p->trapframe_va);
 }
 
 // interrupts and exceptions from kernel code go here via kernelvec,
@@ -150,6 +170,11 @@ kerneltrap()
     panic("kerneltrap");
   }
 
+  // kernelvec leaves s0 alone, so the interrupted code's frame
+  // pointer is the one kerneltrap()'s own frame saved.
+  if(which_dev == 2)
+    prof_tick(0, sepc, *(uint64*)(r_fp() - 16));
+
   // give up the CPU if this is a timer interrupt.
   if(which_dev == 2 && myproc() != 0 && myproc()->state == RUNNING)
     yield();
@@ -160,13 +185,28 @@ kerneltrap()
   w_sstatus(sstatus);
 }
 
+// with TICKLESS, no hart takes a clock interrupt every tick,
+// so ticks follows the time CSR instead of counting them.
+// bring it up to date. tickslock must be held.
+void
+ticksync(void)
+{
+  if(TICKLESS)
+    ticks = r_time() / TICK_INTERVAL;
+}
+
 void
 clockintr()
 {
   acquire(&tickslock);
-  ticks++;
-  wakeup(&ticks);
+  if(TICKLESS)
+    ticksync();
+  else
+    ticks++;
   release(&tickslock);
+
+  // wake the sleepers whose deadline has come.
+  timer_run();
 }
 
 // check if it's an external interrupt or software interrupt,
@@ -202,17 +242,30 @@ devintr()
 
     return 1;
   } else if(scause == 0x8000000000000001L){
-    // software interrupt from a machine-mode timer interrupt,
-    // forwarded by timervec in kernelvec.S.
+    // software interrupt from a machine-mode timer interrupt
+    // or IPI, forwarded by timervec in kernelvec.S.
 
-    if(cpuid() == 0){
-      clockintr();
-    }
-    
     // acknowledge the software interrupt by clearing
     // the SSIP bit in sip.
     w_sip(r_sip() & ~2);
 
+    // IPIs carry TLB shootdown requests.
+    tlb_flush();
+
+    if(!timer_ticked())
+      return 1;
+
+    if(TICKLESS){
+      // whichever hart is interrupted keeps time. one running a
+      // process may only have been interrupted for a sleeper's
+      // deadline, which doesn't end the process's time slice.
+      clockintr();
+      if(myproc() == 0 || !timer_tick())
+        return 1;
+    } else if(cpuid() == 0){
+      clockintr();
+    }
+
     return 2;
   } else {
     return 0;
@@ -9,6 +9,7 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "defs.h"
+#include "wchan.h"
 
 // the UART control registers are memory-mapped
 // at address UART0. this macro returns the
@@ -188,3 +189,13 @@ uartintr(void)
   uartstart();
   release(&uart_tx_lock);
 }
+
+// is chan what uartputc() waits on for room in the buffer?
+int
+uart_wchan(void *chan, uint64 *arg)
+{
+  if(chan != &uart_tx_r)
+    return WCHAN_NONE;
+  *arg = 1;
+  return WCHAN_CONSOLE;
+}
@@ -0,0 +1,14 @@
+// A read-only page the kernel maps at VDSO in each user page
+// table, so that ulib can answer getpid() and uptime() without
+// a system call. user code may read the time CSR itself.
+
+#define VDSO_NS_SHIFT 8
+
+struct vdso {
+  int pid;               // process the page table was made for
+  int shared;            // set once clone() shares the page table
+  uint64 tick_interval;  // time CSR cycles per tick, 0 if ticks
+                         // don't follow the time CSR (no TICKLESS)
+  uint64 ns_mult;        // ns since boot = (time * ns_mult) >> ns_shift
+  uint64 ns_shift;
+};
@@ -7,6 +7,7 @@
 
 #include "types.h"
 #include "riscv.h"
+#include "trace.h"
 #include "defs.h"
 #include "param.h"
 #include "memlayout.h"
@@ -15,6 +16,7 @@
 #include "fs.h"
 #include "buf.h"
 #include "virtio.h"
+#include "wchan.h"
 
 // the address of virtio mmio register r.
 #define R(r) ((volatile uint32 *)(VIRTIO0 + (r)))
@@ -279,6 +281,7 @@ virtio_disk_rw(struct buf *b, int write)
   __sync_synchronize();
 
   *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+  trace(TR_DISK_SUBMIT, (uint64)b->blockno << 1 | write);
 
   // Wait for virtio_disk_intr() to say request has finished.
   while(b->disk == 1) {
@@ -318,6 +321,7 @@ virtio_disk_intr()
 
     struct buf *b = disk.info[id].b;
     b->disk = 0;   // disk is done with buf
+    trace(TR_DISK_DONE, b->blockno);
     wakeup(b);
 
     disk.used_idx += 1;
@@ -325,3 +329,10 @@ virtio_disk_intr()
 
   release(&disk.vdisk_lock);
 }
+
+// is chan what alloc3_desc() waits on for free descriptors?
+int
+disk_wchan(void *chan)
+{
+  return chan == &disk.free[0] ? WCHAN_DISKDESC : WCHAN_NONE;
+}
@@ -30,6 +30,9 @@ kvmmake(void)
   // virtio mmio disk interface
   kvmmap(kpgtbl, VIRTIO0, VIRTIO0, PGSIZE, PTE_R | PTE_W);
 
+  // CLINT, for sending IPIs
+  kvmmap(kpgtbl, CLINT, CLINT, 0x10000, PTE_R | PTE_W);
+
   // PLIC
   kvmmap(kpgtbl, PLIC, PLIC, 0x400000, PTE_R | PTE_W);
 
@@ -85,6 +88,8 @@ kvminithart()
 pte_t *
 walk(pagetable_t pagetable, uint64 va, int alloc)
 {
+  pagetable_t root = pagetable;
+
   if(va >= MAXVA)
     panic("walk");
 
@@ -97,6 +102,7 @@ walk(pagetable_t pagetable, uint64 va, int alloc)
         return 0;
       memset(pagetable, 0, PGSIZE);
       *pte = PA2PTE(pagetable) | PTE_V;
+      pagetable_account(root, 0, 1);
     }
   }
   return &pagetable[PX(0, va)];
@@ -144,6 +150,7 @@ mappages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
 {
   uint64 a, last;
   pte_t *pte;
+  int n = 0, r = 0;
 
   if(size == 0)
     panic("mappages: size");
@@ -151,31 +158,42 @@ mappages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
   a = PGROUNDDOWN(va);
   last = PGROUNDDOWN(va + size - 1);
   for(;;){
-    if((pte = walk(pagetable, a, 1)) == 0)
-      return -1;
+    if((pte = walk(pagetable, a, 1)) == 0){
+      r = -1;
+      break;
+    }
     if(*pte & PTE_V)
       panic("mappages: remap");
     *pte = PA2PTE(pa) | perm | PTE_V;
+    n++;
     if(a == last)
       break;
     a += PGSIZE;
     pa += PGSIZE;
   }
-  return 0;
+  // count what was mapped, even if not all of it: the
+  // caller unmaps that.
+  if(perm & PTE_U)
+    pagetable_account(pagetable, n, 0);
+  return r;
 }
 
 // Remove npages of mappings starting from va. va must be
 // page-aligned. The mappings must exist.
 // Optionally free the physical memory.
+// Works in batches, so that other harts running this page table
+// have dropped their TLB entries before a batch's pages are freed.
 void
 uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
 {
-  uint64 a;
+  uint64 a, start, pa[NTLBBATCH];
   pte_t *pte;
+  int n = 0, user = 0;
 
   if((va % PGSIZE) != 0)
     panic("uvmunmap: not aligned");
 
+  start = va;
   for(a = va; a < va + npages*PGSIZE; a += PGSIZE){
     if((pte = walk(pagetable, a, 0)) == 0)
       panic("uvmunmap: walk");
@@ -183,12 +201,20 @@ uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
       panic("uvmunmap: not mapped");
     if(PTE_FLAGS(*pte) == PTE_V)
       panic("uvmunmap: not a leaf");
-    if(do_free){
-      uint64 pa = PTE2PA(*pte);
-      kfree((void*)pa);
-    }
+    if(*pte & PTE_U)
+      user++;
+    pa[n++] = PTE2PA(*pte);
     *pte = 0;
+    if(n == NTLBBATCH || a + PGSIZE == va + npages*PGSIZE){
+      tlb_shootdown(pagetable, start, n);
+      if(do_free)
+        for(int i = 0; i < n; i++)
+          kfree((void*)pa[i]);
+      start = a + PGSIZE;
+      n = 0;
+    }
   }
+  pagetable_account(pagetable, -user, 0);
 }
 
 // create an empty user page table.
@@ -343,6 +369,7 @@ uvmclear(pagetable_t pagetable, uint64 va)
   if(pte == 0)
     panic("uvmclear");
   *pte &= ~PTE_U;
+  tlb_shootdown(pagetable, va, 1);
 }
 
 // Copy from kernel to user.
@@ -0,0 +1,67 @@
+// Wait channel classification.
+//
+// A sleeping process's p->chan is the address of whatever it
+// waits for. wchan_classify() asks each subsystem whether the
+// address is one of its objects, to report in ps what the
+// process is blocked on: a pipe, an inode or buffer lock, the
+// disk, the log, a timer and so on.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "proc.h"
+#include "wchan.h"
+#include "defs.h"
+
+extern char end[];  // first address after kernel, see kalloc.c
+
+// Returns the WCHAN_* kind of chan and sets *arg as wchan.h says.
+// file_wchan() takes ftable.lock, so the caller must not hold any
+// p->lock: copy p->chan and release the lock first. chan may be
+// stale by then, which is harmless: it is only compared
+// against known objects.
+int
+wchan_classify(void *chan, uint64 *arg)
+{
+  int kind;
+
+  *arg = 0;
+  if(chan == 0)
+    return WCHAN_NONE;
+  if((kind = proc_wchan(chan, arg)) != WCHAN_NONE ||
+     (kind = file_wchan(chan, arg)) != WCHAN_NONE ||
+     (kind = inode_wchan(chan, arg)) != WCHAN_NONE ||
+     (kind = buf_wchan(chan, arg)) != WCHAN_NONE ||
+     (kind = log_wchan(chan)) != WCHAN_NONE ||
+     (kind = disk_wchan(chan)) != WCHAN_NONE ||
+     (kind = console_wchan(chan, arg)) != WCHAN_NONE ||
+     (kind = uart_wchan(chan, arg)) != WCHAN_NONE)
+    return kind;
+
+  // futex() sleeps on the physical address of the futex word,
+  // in a page kalloc() gave out. pipes live there too, but
+  // they were found above.
+  *arg = (uint64)chan;
+  if((uint64)chan >= PGROUNDUP((uint64)end) && (uint64)chan < PHYSTOP)
+    return WCHAN_FUTEX;
+  return WCHAN_OTHER;
+}
+
+// If a process sleeping on chan, of kind, waits for a sleeplock,
+// returns the lock's name and sets *holder to the pid holding it,
+// 0 if none. Otherwise returns 0.
+char*
+wchan_sleeplock(int kind, void *chan, int *holder)
+{
+  struct sleeplock *lk = chan;  // acquiresleep() sleeps on the lock
+
+  *holder = 0;
+  if(kind != WCHAN_INODE && kind != WCHAN_BUF)
+    return 0;
+  if(lk->locked)
+    *holder = lk->pid;
+  return lk->name;
+}
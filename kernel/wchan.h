@@ -0,0 +1,17 @@
+// what a sleeping process waits for, as told from its wait
+// channel by wchan_classify(), and what the argument that comes
+// with each kind means.
+#define WCHAN_NONE      0   // not sleeping
+#define WCHAN_OTHER     1   // arg: the channel
+#define WCHAN_PIPE      2   // arg: 0 for data to read, 1 for room to write
+#define WCHAN_INODE     3   // an inode's sleeplock; arg: dev << 32 | inum
+#define WCHAN_BUF       4   // a buffer's sleeplock; arg: dev << 32 | blockno
+#define WCHAN_DISK      5   // disk I/O to finish; arg: blockno
+#define WCHAN_DISKDESC  6   // a free virtio descriptor
+#define WCHAN_LOG       7   // log space or a commit, in begin_op()
+#define WCHAN_TIMER     8   // sleep() or nanosleep(); arg: deadline, in time CSR cycles
+#define WCHAN_CHILD     9   // wait() or join()
+#define WCHAN_FUTEX    10   // arg: physical address of the futex word
+#define WCHAN_CONSOLE  11   // arg: 0 for input to read, 1 for room to write
+#define WCHAN_SPINLOCK 12   // running, spinning in acquire(); arg: the lock
+#define NWCHAN         13
@@ -0,0 +1,143 @@
+// Drains the kernel tracepoint buffers and prints the records
+// as a timeline, merged across CPUs by time.
+//
+// usage: ktrace on [mask]    record the events in mask (default all)
+//        ktrace off          stop recording
+//        ktrace dump         print what was recorded since last drained
+//        ktrace cmd args...  run cmd and print what happened meanwhile
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/riscv.h"
+#include "kernel/trace.h"
+#include "user/user.h"
+
+#define NREC (NCPU * 512)
+
+char *evnames[NTREVENT] = {
+  [TR_SWITCH]      "switch",
+  [TR_SLEEP]       "sleep",
+  [TR_WAKEUP]      "wakeup",
+  [TR_BREAD]       "bread",
+  [TR_BWRITE]      "bwrite",
+  [TR_DISK_SUBMIT] "disk_submit",
+  [TR_DISK_DONE]   "disk_done",
+  [TR_KALLOC]      "kalloc",
+  [TR_KFREE]       "kfree",
+  [TR_SYSCALL]     "syscall",
+  [TR_SYSRET]      "sysret",
+  [TR_FAULT]       "fault",
+};
+
+struct trace_rec *recs;
+
+static void
+print_rec(struct trace_rec *r, uint64 t0)
+{
+  uint64 us = cycles_us(r->time - t0);
+  printf("%d.%d%d%d ms  cpu%d  pid %d  ", (int)(us / 1000),
+         (int)(us / 100 % 10), (int)(us / 10 % 10), (int)(us % 10),
+         r->cpu, r->pid);
+  if(r->event < NTREVENT && evnames[r->event])
+    printf("%s", evnames[r->event]);
+  else
+    printf("event %d", r->event);
+
+  switch(r->event){
+  case TR_SWITCH:
+  case TR_WAKEUP:
+    printf(" -> pid %d\n", (int)r->arg);
+    break;
+  case TR_BREAD:
+  case TR_BWRITE:
+    printf(" dev %d block %d\n", (int)(r->arg >> 32), (int)r->arg);
+    break;
+  case TR_DISK_SUBMIT:
+    printf(" block %d %s\n", (int)(r->arg >> 1), (r->arg & 1) ? "write" : "read");
+    break;
+  case TR_DISK_DONE:
+  case TR_SYSCALL:
+  case TR_SYSRET:
+    printf(" %d\n", (int)r->arg);
+    break;
+  case TR_FAULT:
+    printf(" page %p kind %d\n", r->arg & ~(PGSIZE-1), (int)(r->arg & (PGSIZE-1)));
+    break;
+  default:
+    printf(" %p\n", r->arg);
+  }
+}
+
+// drain the buffers and print the records, merging the
+// per-CPU runs ktrace_read() returns by time.
+static void
+dump(void)
+{
+  int start[NCPU+1], pos[NCPU];
+  int n, nrun, i, k;
+
+  if((n = ktrace_read(recs, NREC)) < 0){
+    fprintf(2, "ktrace: ktrace_read failed\n");
+    exit(1);
+  }
+
+  // each CPU's records are one run, in time order.
+  nrun = 0;
+  for(i = 0; i < n; i++)
+    if(nrun == 0 || recs[i].cpu != recs[start[nrun-1]].cpu)
+      start[nrun++] = i;
+  start[nrun] = n;
+  for(k = 0; k < nrun; k++)
+    pos[k] = start[k];
+
+  uint64 t0 = 0;
+  for(i = 0; i < n; i++){
+    int best = -1;
+    for(k = 0; k < nrun; k++)
+      if(pos[k] < start[k+1] &&
+         (best < 0 || recs[pos[k]].time < recs[pos[best]].time))
+        best = k;
+    if(i == 0)
+      t0 = recs[pos[best]].time;
+    print_rec(&recs[pos[best]++], t0);
+  }
+  printf("%d records\n", n);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 2){
+    fprintf(2, "usage: ktrace on [mask] | off | dump | cmd args...\n");
+    exit(1);
+  }
+  if((recs = malloc(NREC * sizeof(struct trace_rec))) == 0){
+    fprintf(2, "ktrace: out of memory\n");
+    exit(1);
+  }
+
+  if(strcmp(argv[1], "on") == 0){
+    ktrace_ctl(argc > 2 ? atoi(argv[2]) : TR_ALL);
+  } else if(strcmp(argv[1], "off") == 0){
+    ktrace_ctl(0);
+  } else if(strcmp(argv[1], "dump") == 0){
+    dump();
+  } else {
+    // throw away older records.
+    while(ktrace_read(recs, NREC) > 0)
+      ;
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "ktrace: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      exec(argv[1], argv + 1);
+      fprintf(2, "ktrace: exec %s failed\n", argv[1]);
+      exit(1);
+    }
+    wait(0);
+    dump();
+  }
+  exit(0);
+}
@@ -0,0 +1,105 @@
+// Spinlock benchmark: a process pinned to each of n harts takes
+// and releases the same kernel lock for a while, with lockbench(),
+// first a test-and-set lock, then a ticket lock. Prints how many
+// times a second the lock changed hands, the fewest and most
+// times one hart got it, and Jain's fairness index over the
+// harts, 1.000 when they all got it equally often.
+//
+// usage: lockbench [harts [ms]]
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/spinlock.h"
+#include "kernel/cpu_info.h"
+#include "user/user.h"
+
+struct result {
+  int hart;
+  int n;
+};
+
+static void
+run(char *name, int kind, int harts, int ms)
+{
+  int go[2], res[2];
+  struct result r;
+  int counts[NCPU];
+  uint64 sum = 0, sumsq = 0;
+  int min = -1, max = 0;
+  int i;
+  char c;
+
+  if(pipe(go) < 0 || pipe(res) < 0){
+    fprintf(2, "lockbench: pipe failed\n");
+    exit(1);
+  }
+  for(i = 0; i < harts; i++){
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "lockbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      close(go[1]);
+      close(res[0]);
+      sched_setaffinity(0, 1 << i);
+      read(go[0], &c, 1);  // start together
+      r.hart = i;
+      r.n = lockbench(kind, ms);
+      write(res[1], &r, sizeof(r));
+      exit(0);
+    }
+  }
+  close(go[0]);
+  close(res[1]);
+  sleep(1);  // let them move to their harts
+  for(i = 0; i < harts; i++)
+    write(go[1], "g", 1);
+  close(go[1]);
+
+  for(i = 0; i < harts; i++){
+    if(read(res[0], &r, sizeof(r)) != sizeof(r) || r.n < 0){
+      fprintf(2, "lockbench: lockbench failed\n");
+      exit(1);
+    }
+    counts[r.hart] = r.n;
+  }
+  close(res[0]);
+  for(i = 0; i < harts; i++)
+    wait(0);
+
+  for(i = 0; i < harts; i++){
+    sum += counts[i];
+    sumsq += (uint64)counts[i] * counts[i];
+    if(min < 0 || counts[i] < min)
+      min = counts[i];
+    if(counts[i] > max)
+      max = counts[i];
+  }
+  int fair = sumsq ? (int)(sum * sum * 1000 / (harts * sumsq)) : 0;
+  printf("%s\t%d\t%l\t\t%d\t%d\t%d.%d%d%d\n", name, harts, sum * 1000 / ms,
+         min, max, fair / 1000, fair / 100 % 10, fair / 10 % 10, fair % 10);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct cpu_info cpus[NCPU];
+  int ncpu = ps_cpus(cpus, NCPU);
+  int harts = ncpu;
+  int ms = 1000;
+
+  if(argc > 1)
+    harts = atoi(argv[1]);
+  if(argc > 2)
+    ms = atoi(argv[2]);
+  if(harts < 1 || harts > ncpu || ms < 1){
+    fprintf(2, "usage: lockbench [harts [ms]]\n");
+    exit(1);
+  }
+
+  printf("lock\tharts\tacquires/s\tmin\tmax\tfairness\n");
+  run("tas", SPIN_TAS, harts, ms);
+  run("ticket", SPIN_TICKET, harts, ms);
+  exit(0);
+}
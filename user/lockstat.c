@@ -0,0 +1,70 @@
+// Runs a command with spinlock statistics on, then prints how
+// contended each lock was, by name, most time spinning first.
+//
+// usage: lockstat cmd args...
+
+#include "kernel/types.h"
+#include "kernel/lockstat.h"
+#include "user/user.h"
+
+struct lock_stat stats[NLOCKSTAT];
+
+static void
+print_us(uint64 cycles)
+{
+  printf("%l\t", cycles_us(cycles));
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n, i, j, pid;
+
+  if(argc < 2){
+    fprintf(2, "usage: lockstat cmd args...\n");
+    exit(1);
+  }
+
+  if(lockstat_ctl(1) < 0){
+    fprintf(2, "lockstat: kernel built without LOCKSTAT\n");
+    exit(1);
+  }
+  if((pid = fork()) < 0){
+    fprintf(2, "lockstat: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "lockstat: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+  lockstat_ctl(0);
+
+  if((n = lockstat_read(stats, NLOCKSTAT)) < 0){
+    fprintf(2, "lockstat: lockstat_read failed\n");
+    exit(1);
+  }
+
+  // most time spinning first.
+  for(i = 1; i < n; i++){
+    struct lock_stat s = stats[i];
+    for(j = i; j > 0 && stats[j-1].spin_cycles < s.spin_cycles; j--)
+      stats[j] = stats[j-1];
+    stats[j] = s;
+  }
+
+  printf("acquires\tcontended\tspin_us\tmax\thold_us\tmax\tlock\n");
+  for(i = 0; i < n; i++){
+    struct lock_stat *s = &stats[i];
+    if(s->acquires == 0)
+      continue;
+    printf("%l\t\t%l\t\t", s->acquires, s->contended);
+    print_us(s->spin_cycles);
+    print_us(s->spin_max);
+    print_us(s->hold_cycles);
+    print_us(s->hold_max);
+    printf("%s\n", s->name);
+  }
+  exit(0);
+}
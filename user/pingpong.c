@@ -0,0 +1,75 @@
+// Context switch benchmark: a parent and a child pinned to the
+// same CPU bounce a byte through two pipes, each touching its
+// own pages every round, so each round trip switches address
+// spaces twice. Run it with ASID 1 and ASID 0 in kernel/param.h
+// to see what keeping TLB entries across switches saves.
+//
+// usage: pingpong [rounds [pages]]
+
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+static void
+touch(char *buf, int pages, int round)
+{
+  for(int i = 0; i < pages; i++)
+    buf[i*PGSIZE] = round;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int rounds = 10000, pages = 16;
+  int ping[2], pong[2];
+  char c = 0;
+
+  if(argc > 1)
+    rounds = atoi(argv[1]);
+  if(argc > 2)
+    pages = atoi(argv[2]);
+
+  char *buf = sbrk(pages*PGSIZE);
+  if(buf == (char*)-1){
+    fprintf(2, "pingpong: sbrk failed\n");
+    exit(1);
+  }
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    fprintf(2, "pingpong: pipe failed\n");
+    exit(1);
+  }
+  // both on CPU 0, so every round trip is two context switches
+  // rather than two CPUs spinning in parallel.
+  sched_setaffinity(0, 1);
+
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "pingpong: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    for(int i = 0; i < rounds; i++){
+      if(read(ping[0], &c, 1) != 1)
+        exit(1);
+      touch(buf, pages, i);
+      write(pong[1], &c, 1);
+    }
+    exit(0);
+  }
+
+  int start = uptime();
+  for(int i = 0; i < rounds; i++){
+    write(ping[1], &c, 1);
+    if(read(pong[0], &c, 1) != 1){
+      fprintf(2, "pingpong: child died\n");
+      exit(1);
+    }
+    touch(buf, pages, i);
+  }
+  int elapsed = uptime() - start;
+  wait(0);
+
+  printf("pingpong: %d round trips, %d pages each: %d ticks\n",
+         rounds, pages, elapsed);
+  exit(0);
+}
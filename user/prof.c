@@ -0,0 +1,268 @@
+// Runs a command with the sampling profiler on, then resolves
+// the samples against the symbol tables on the file system
+// (kernel.sym, and cat.sym and so on for each program).
+//
+// usage: prof cmd args...      flat profile: samples per function
+//        prof -f cmd args...   folded stacks, for flamegraph.pl
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/prof.h"
+#include "user/user.h"
+
+#define NSAMPLE (NCPU * 512)
+#define NTAB    16           // symbol tables loaded at once
+#define NENT    1024         // distinct functions or stacks
+
+struct symtab {
+  char name[16];             // program, or "kernel"
+  int n;
+  uint64 *addr;              // sorted
+  char **sym;
+} tabs[NTAB];
+int ntab;
+
+struct ent {
+  char *key;
+  int n;
+} ents[NENT];
+int nent;
+
+struct prof_sample *samples;
+char line[512];
+
+// load name.sym, a line per symbol: its address in hex, a space
+// and its name. a table is loaded once; if there is no file it
+// stays empty and every pc in it resolves to "?".
+static struct symtab*
+symtab(char *name)
+{
+  struct symtab *t;
+  struct stat st;
+  char path[32], *buf, *p, *q;
+  int fd, i, j;
+
+  for(t = tabs; t < &tabs[ntab]; t++)
+    if(strcmp(t->name, name) == 0)
+      return t;
+  if(ntab == NTAB)
+    return 0;
+  t = &tabs[ntab++];
+  strcpy(t->name, name);
+
+  if(strlen(name) + 5 > sizeof(path))
+    return t;
+  strcpy(path, name);
+  strcpy(path + strlen(name), ".sym");
+  if((fd = open(path, O_RDONLY)) < 0)
+    return t;
+  if(fstat(fd, &st) < 0 || (buf = malloc(st.size + 1)) == 0){
+    close(fd);
+    return t;
+  }
+  if(read(fd, buf, st.size) != st.size){
+    close(fd);
+    return t;
+  }
+  close(fd);
+  buf[st.size] = 0;
+
+  int max = 0;
+  for(p = buf; *p; p++)
+    if(*p == '\n')
+      max++;
+  t->addr = malloc(max * sizeof(uint64));
+  t->sym = malloc(max * sizeof(char*));
+  if(t->addr == 0 || t->sym == 0)
+    return t;
+
+  for(p = buf; *p; p = q + 1){
+    if((q = strchr(p, '\n')) == 0)
+      break;
+    *q = 0;
+    uint64 a = 0;
+    for(; *p && *p != ' '; p++)
+      a = a*16 + (*p >= 'a' ? *p - 'a' + 10 : *p - '0');
+    if(*p++ != ' ')
+      continue;
+    // skip section names and source files.
+    int len = strlen(p);
+    if(p[0] == '.' || (len > 2 && p[len-2] == '.'))
+      continue;
+    // keep sorted by address.
+    for(i = t->n; i > 0 && t->addr[i-1] > a; i--)
+      ;
+    for(j = t->n; j > i; j--){
+      t->addr[j] = t->addr[j-1];
+      t->sym[j] = t->sym[j-1];
+    }
+    t->addr[i] = a;
+    t->sym[i] = p;
+    t->n++;
+  }
+  return t;
+}
+
+// the function holding pc: the last symbol at or below it.
+static char*
+lookup(struct symtab *t, uint64 pc)
+{
+  int lo = 0, hi, mid;
+
+  if(t == 0 || t->n == 0 || pc < t->addr[0])
+    return "?";
+  hi = t->n - 1;
+  while(lo < hi){
+    mid = (lo + hi + 1) / 2;
+    if(t->addr[mid] <= pc)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return t->sym[lo];
+}
+
+// the function of the i'th pc of s. the others are return
+// addresses, just past the call, which can be past the end
+// of the caller too.
+static char*
+frame(struct prof_sample *s, int i)
+{
+  uint64 pc = i == 0 ? s->pc[0] : s->pc[i] - 4;
+
+  return lookup(symtab(s->user ? s->name : "kernel"), pc);
+}
+
+// append str to line at *pos, if it fits.
+static void
+append(int *pos, char *str)
+{
+  int len = strlen(str);
+
+  if(*pos + len >= sizeof(line))
+    return;
+  memmove(line + *pos, str, len);
+  *pos += len;
+  line[*pos] = 0;
+}
+
+// count one more for key, a string in line.
+static void
+count(char *key)
+{
+  struct ent *e;
+
+  for(e = ents; e < &ents[nent]; e++){
+    if(strcmp(e->key, key) == 0){
+      e->n++;
+      return;
+    }
+  }
+  if(nent == NENT || (e->key = malloc(strlen(key) + 1)) == 0)
+    return;
+  strcpy(e->key, key);
+  e->n = 1;
+  nent++;
+}
+
+static void
+flat(struct prof_sample *s)
+{
+  int pos = 0;
+
+  append(&pos, s->user ? s->name : "kernel");
+  append(&pos, ":");
+  append(&pos, frame(s, 0));
+  count(line);
+}
+
+// the process, then its frames from the outermost in, kernel
+// functions marked _[k] as flamegraph.pl expects.
+static void
+folded(struct prof_sample *s)
+{
+  int pos = 0;
+  int i;
+
+  append(&pos, s->pid ? s->name : "scheduler");
+  for(i = s->depth - 1; i >= 0; i--){
+    append(&pos, ";");
+    append(&pos, frame(s, i));
+    if(!s->user)
+      append(&pos, "_[k]");
+  }
+  count(line);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fold = 0;
+  int n, total, i, j;
+
+  if(argc > 1 && strcmp(argv[1], "-f") == 0){
+    fold = 1;
+    argc--;
+    argv++;
+  }
+  if(argc < 2){
+    fprintf(2, "usage: prof [-f] cmd args...\n");
+    exit(1);
+  }
+  if((samples = malloc(NSAMPLE * sizeof(struct prof_sample))) == 0){
+    fprintf(2, "prof: out of memory\n");
+    exit(1);
+  }
+
+  // throw away older samples.
+  while(prof_read(samples, NSAMPLE) > 0)
+    ;
+  prof_ctl(1);
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "prof: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "prof: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+  prof_ctl(0);
+
+  if((n = prof_read(samples, NSAMPLE)) < 0){
+    fprintf(2, "prof: prof_read failed\n");
+    exit(1);
+  }
+  for(i = 0; i < n; i++){
+    if(fold)
+      folded(&samples[i]);
+    else
+      flat(&samples[i]);
+  }
+
+  // most samples first.
+  for(i = 1; i < nent; i++){
+    struct ent e = ents[i];
+    for(j = i; j > 0 && ents[j-1].n < e.n; j--)
+      ents[j] = ents[j-1];
+    ents[j] = e;
+  }
+
+  if(fold){
+    for(i = 0; i < nent; i++)
+      printf("%s %d\n", ents[i].key, ents[i].n);
+    exit(0);
+  }
+  total = n;
+  printf("samples      %%  function\n");
+  for(i = 0; i < nent; i++){
+    int pm = ents[i].n * 1000 / total;
+    printf("%d\t%d.%d  %s\n", ents[i].n, pm / 10, pm % 10, ents[i].key);
+  }
+  printf("%d samples\n", total);
+  exit(0);
+}
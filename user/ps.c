@@ -3,44 +3,267 @@
 #include "user/user.h"  // syscalls
 #include "kernel/param.h"
 #include "kernel/process_info.h"
+#include "kernel/cpu_info.h"
+#include "kernel/lathist.h"
+#include "kernel/sysstat.h"
+#include "kernel/fault.h"
 #include "kernel/riscv.h"
+#include "kernel/memlayout.h"
+#include "kernel/ptmap.h"
 #include "kernel/syscall.h"
+#include "kernel/iovec.h"
+#include "kernel/wchan.h"
+#include "kernel/blocked_info.h"
 
 
 void print_syscall_name(int x) {
-  if (x == SYS_fork) printf("fork");
-  else if (x == SYS_exit) printf("exit");
-  else if (x == SYS_wait) printf("wait");
-  else if (x == SYS_pipe) printf("pipe");
-  else if (x == SYS_read) printf("read");
-  else if (x == SYS_kill) printf("kill");
-  else if (x == SYS_exec) printf("exec");
-  else if (x == SYS_fstat) printf("fstat");
-  else if (x == SYS_chdir) printf("chdir");
-  else if (x == SYS_dup) printf("dup");
-  else if (x == SYS_getpid) printf("getpid");
-  else if (x == SYS_sbrk) printf("sbrk");
-  else if (x == SYS_sleep) printf("sleep");
-  else if (x == SYS_uptime) printf("uptime");
-  else if (x == SYS_open) printf("open");
-  else if (x == SYS_write) printf("write");
-  else if (x == SYS_mknod) printf("mknod");
-  else if (x == SYS_unlink) printf("unlink");
-  else if (x == SYS_link) printf("link");
-  else if (x == SYS_mkdir) printf("mkdir");
-  else if (x == SYS_close) printf("close");
-  else if (x == SYS_dummy) printf("dummy");
-  else if (x == SYS_ps_list) printf("ps_list");
-  else if (x == SYS_ps_info) printf("ps_info");
-  else if (x == SYS_ps_pt0) printf("ps_pt0");
-  else if (x == SYS_ps_pt1) printf("ps_pt1");
-  else if (x == SYS_ps_pt2) printf("ps_pt2");
-  else if (x == SYS_ps_copy) printf("ps_copy");
-  else if (x == SYS_ps_sleep_write) printf("ps_sleep_write");
+  char* name = syscall_name(x);
+  if (name) printf("%s", name);
   else printf("unknown syscall: %d", x);
 }
 
 
+// parses a decimal or 0x-prefixed hex number
+uint parse_uint(char* s) {
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        uint x = 0;
+        for (s += 2; *s; ++s) {
+            if (*s >= '0' && *s <= '9') x = x * 16 + (*s - '0');
+            else if (*s >= 'a' && *s <= 'f') x = x * 16 + (*s - 'a' + 10);
+            else if (*s >= 'A' && *s <= 'F') x = x * 16 + (*s - 'A' + 10);
+            else break;
+        }
+        return x;
+    }
+    return atoi(s);
+}
+
+
+// prints microseconds as seconds, e.g. 12.000345
+void print_us(uint64 us) {
+  uint frac = us % 1000000;
+  printf("%d.", (int) (us / 1000000));
+  for (uint d = 100000; d > 1 && frac < d; d /= 10) {
+    printf("0");
+  }
+  printf("%d", frac);
+}
+
+// prints the nonempty buckets of a latency histogram, in ns.
+void print_lathist(struct lathist* lat) {
+  for (int b = 0; b < NLATBUCKET; ++b) {
+    if (lat->hist[b] == 0) {
+      continue;
+    }
+    if (b == NLATBUCKET - 1) {
+      printf("\t>= %l ns: %l\n", cycles_ns(1L << b), lat->hist[b]);
+    } else {
+      printf("\t< %l ns: %l\n", cycles_ns(2L << b), lat->hist[b]);
+    }
+  }
+}
+
+// how to print the arguments of the calls a process can block
+// in: i an int, s a string in the process, p a pointer.
+char* blocked_args[] = {
+  [SYS_exit] "i",
+  [SYS_wait] "p",
+  [SYS_read] "ipi",
+  [SYS_exec] "sp",
+  [SYS_fstat] "ip",
+  [SYS_chdir] "s",
+  [SYS_sleep] "i",
+  [SYS_open] "si",
+  [SYS_write] "ipi",
+  [SYS_mknod] "sii",
+  [SYS_unlink] "s",
+  [SYS_link] "ss",
+  [SYS_mkdir] "s",
+  [SYS_close] "i",
+  [SYS_join] "i",
+  [SYS_futex] "pii",
+  [SYS_nanosleep] "i",
+  [SYS_ring_enter] "i",
+  [SYS_trace_read] "ipi",
+};
+
+// prints a blocked call and its arguments, reading strings out
+// of the process with process_vm_readv() so it is not disturbed.
+void print_blocked_call(struct blocked_info* b) {
+  char* kinds = "pppppp";
+  if (b->syscall > 0 && b->syscall < sizeof(blocked_args) / sizeof(blocked_args[0]) && blocked_args[b->syscall]) {
+    kinds = blocked_args[b->syscall];
+  }
+
+  print_syscall_name(b->syscall);
+  printf("(");
+  for (int i = 0; kinds[i]; ++i) {
+    if (i > 0) {
+      printf(", ");
+    }
+    if (kinds[i] == 'i') {
+      printf("%d", (int) b->args[i]);
+    } else if (kinds[i] == 's') {
+      char str[64];
+      struct iovec local = { (uint64) str, sizeof(str) - 1 };
+      struct iovec remote = { b->args[i], sizeof(str) - 1 };
+      // short if the string ends right before an unmapped page.
+      int n = process_vm_readv(b->pid, &local, 1, &remote, 1);
+      if (n < 0) {
+        printf("%p", b->args[i]);
+      } else {
+        str[n] = 0;
+        printf("\"%s\"", str);
+      }
+    } else {
+      printf("%p", b->args[i]);
+    }
+  }
+  printf(")");
+}
+
+// prints what a process is blocked on, see wchan.h.
+void print_wchan(int wchan, uint64 arg) {
+  if (wchan == WCHAN_NONE) printf("-");
+  else if (wchan == WCHAN_PIPE) printf(arg ? "pipe, full" : "pipe, empty");
+  else if (wchan == WCHAN_INODE) printf("inode %d:%d lock", (int) (arg >> 32), (int) arg);
+  else if (wchan == WCHAN_BUF) printf("buf %d:%d lock", (int) (arg >> 32), (int) arg);
+  else if (wchan == WCHAN_DISK) printf("disk, block %d", (int) arg);
+  else if (wchan == WCHAN_DISKDESC) printf("disk, descriptors");
+  else if (wchan == WCHAN_LOG) printf("log");
+  else if (wchan == WCHAN_CHILD) printf("child");
+  else if (wchan == WCHAN_FUTEX) printf("futex %p", arg);
+  else if (wchan == WCHAN_CONSOLE) printf(arg ? "console output" : "console input");
+  else if (wchan == WCHAN_SPINLOCK) printf("spinlock %p", arg);
+  else if (wchan == WCHAN_TIMER) {
+    uint64 now = r_time();
+    printf("timer, ");
+    print_us(arg > now ? cycles_us(arg - now) : 0);
+    printf(" left");
+  }
+  else printf("chan %p", arg);
+}
+
+// ps top builds each screen here and writes it at once, rather
+// than making a system call per printf.
+struct screen {
+  char* buf;
+  int len;
+  int cap;
+};
+
+void scr_str(struct screen* s, char* str, int width) {
+  int len = strlen(str);
+  for (int i = 0; i < len && s->len < s->cap; ++i) {
+    s->buf[s->len++] = str[i];
+  }
+  for (int i = len; i < width && s->len < s->cap; ++i) {
+    s->buf[s->len++] = ' ';
+  }
+}
+
+// x, and frac digits of it after a point if frac > 0, e.g. x = 123
+// and frac = 1 is 12.3
+void scr_num(struct screen* s, int x, int frac, int width) {
+  char tmp[24];
+  int i = sizeof(tmp) - 1;
+  int neg = x < 0;
+  uint u = neg ? -x : x;
+
+  tmp[i] = 0;
+  do {
+    tmp[--i] = '0' + u % 10;
+    u /= 10;
+    if (--frac == 0) {
+      tmp[--i] = '.';
+      if (u == 0) {
+        tmp[--i] = '0';
+      }
+    }
+  } while (u != 0 || frac > 0);
+  if (neg) {
+    tmp[--i] = '-';
+  }
+  scr_str(s, tmp + i, width);
+}
+
+// delta of x per second over dt_us microseconds.
+int per_sec(uint64 x, uint64 dt_us) {
+  return dt_us == 0 ? 0 : (int) (x * 1000000 / dt_us);
+}
+
+// one screen of ps top: each process in cur, busiest first, with
+// its rates since prev, taken dt_us microseconds earlier.
+void top_screen(struct screen* s, struct process_info* cur, int ncur,
+                struct process_info* prev, int nprev, uint64 dt_us, int ticks) {
+
+  int cpu[NPROC];     // tenths of a percent
+  int order[NPROC];
+  int total = 0;
+
+  for (int i = 0; i < ncur; ++i) {
+    struct process_info* p = &cur[i];
+    struct process_info* q = 0;
+    for (int j = 0; j < nprev; ++j) {
+      if (prev[j].pid == p->pid) {
+        q = &prev[j];
+        break;
+      }
+    }
+    uint64 busy = p->utime_us + p->stime_us - (q ? q->utime_us + q->stime_us : 0);
+    cpu[i] = dt_us == 0 ? 0 : (int) (busy * 1000 / dt_us);
+    total += cpu[i];
+
+    int k = i;
+    for (; k > 0 && cpu[order[k - 1]] < cpu[i]; --k) {
+      order[k] = order[k - 1];
+    }
+    order[k] = i;
+  }
+
+  s->len = 0;
+  scr_str(s, "\033[H\033[J", 0);  // home, clear screen
+  scr_str(s, "ps top: ", 0);
+  scr_num(s, ncur, 0, 0);
+  scr_str(s, " processes, cpu ", 0);
+  scr_num(s, total, 1, 0);
+  scr_str(s, "%, every ", 0);
+  scr_num(s, ticks, 0, 0);
+  scr_str(s, " ticks\n\n", 0);
+  scr_str(s, "PID", 6);
+  scr_str(s, "NAME", 12);
+  scr_str(s, "STATE", 10);
+  scr_str(s, "CPU%", 8);
+  scr_str(s, "CSW/s", 8);
+  scr_str(s, "SYS/s", 9);
+  scr_str(s, "MEM_KB", 9);
+  scr_str(s, "RSS", 7);
+  scr_str(s, "dRSS/s\n", 0);
+
+  for (int k = 0; k < ncur; ++k) {
+    struct process_info* p = &cur[order[k]];
+    struct process_info* q = 0;
+    for (int j = 0; j < nprev; ++j) {
+      if (prev[j].pid == p->pid) {
+        q = &prev[j];
+        break;
+      }
+    }
+    scr_num(s, p->pid, 0, 6);
+    scr_str(s, p->proc_name, 12);
+    scr_str(s, p->state, 10);
+    scr_num(s, cpu[order[k]], 1, 8);
+    // uint deltas are right even if the counters wrapped.
+    scr_num(s, per_sec((uint) (p->context_switches - (q ? q->context_switches : 0)), dt_us), 0, 8);
+    scr_num(s, per_sec((uint) (p->syscalls - (q ? q->syscalls : 0)), dt_us), 0, 9);
+    scr_num(s, p->mem_size / 1024, 0, 9);
+    scr_num(s, p->rss_pages, 0, 7);
+    int drss = p->rss_pages - (q ? q->rss_pages : 0);
+    scr_num(s, dt_us == 0 ? 0 : (int) ((long) drss * 1000000 / (long) dt_us), 0, 0);
+    scr_str(s, "\n", 0);
+  }
+}
+
 void print_pte_info(int ind, uint64 pte, int v) {
 
     if (!(PTE_V && pte)) {
@@ -79,11 +302,18 @@ main(int argc, char* argv[]) {
         printf("- ps count\n");
         printf("- ps pids\n");
         printf("- ps list\n");
+        printf("- ps top [<ticks> [<count>]]\n");
         printf("- ps pt 0 <pid> [-v]\n");
         printf("- ps pt 1 <pid> <address> [-v]\n");
         printf("- ps pt 2 <pid> <address> [-v]\n");
+        printf("- ps maps <pid>\n");
         printf("- ps dump <pid> <address> <size>\n");
         printf("- ps sleep-write <pid>\n");
+        printf("- ps blocked\n");
+        printf("- ps affinity <pid> [<mask>]\n");
+        printf("- ps cpus\n");
+        printf("- ps syscalls [-h]\n");
+        printf("- ps faults\n");
        
         exit(0);
     }
@@ -142,43 +372,129 @@ main(int argc, char* argv[]) {
             exit(1);
         }
 
-        int my_pids[NPROC];
-        for (int i = 0; i < NPROC; ++i) {
-            my_pids[i] = -1;
+        // one consistent snapshot, too big for the stack.
+        struct process_info* infos = malloc(NPROC * sizeof(struct process_info));
+        if (infos == 0) {
+            printf("ps: out of memory\n");
+            exit(1);
         }
 
-        int proc_cnt = ps_list(NPROC, my_pids);
+        int proc_cnt = ps_snapshot(infos, NPROC, 0);
+        if (proc_cnt == -1) {
+            printf("ps_snapshot: internal error\n");
+            exit(-1);
+        }
+        if (proc_cnt > NPROC) {
+            proc_cnt = NPROC;
+        }
 
         for (int i = 0; i < proc_cnt; ++i) {
 
-            struct process_info psinfo = {};
-            int res = ps_info(my_pids[i], &psinfo);
-
-            if (res == -1) {
-                printf("ps_info: cannot get info about pid = %d\n\n", my_pids[i]);
-            }
-            
-            else if (res == -2) {
-                printf("ps_info: process pid %d is unused at the moment\n", i);
+            struct process_info psinfo = infos[i];
+
+            printf("info about pid = %d:\n", psinfo.pid);
+            printf("state = %s\n", psinfo.state);
+            printf("parent_id = %d\n", psinfo.parent_pid);
+            printf("mem_size = %d bytes\n", psinfo.mem_size);
+            printf("rss = %d pages, %d shared\n", psinfo.rss_pages, psinfo.shared_pages);
+            printf("page_tables = %d pages\n", psinfo.pt_pages);
+            printf("kernel = %d pages\n", psinfo.kernel_pages);
+            printf("files_count = %d\n", psinfo.files_count);
+            printf("proc_name = %s\n", psinfo.proc_name);
+            printf("proc_ticks = %d\n", psinfo.proc_ticks);
+            printf("run_time = %d\n", psinfo.run_time);
+            printf("context_switches = %d\n", psinfo.context_switches);
+            printf("syscalls = %d\n", psinfo.syscalls);
+            printf("wchan = ");
+            print_wchan(psinfo.wchan, psinfo.wchan_arg);
+            printf("\n");
+            if (psinfo.lock_name[0]) {
+                printf("lock = %s, held by pid %d\n", psinfo.lock_name, psinfo.lock_holder);
             }
+            printf("read = %l bytes in %d calls\n", psinfo.read_bytes, psinfo.reads);
+            printf("write = %l bytes in %d calls\n", psinfo.write_bytes, psinfo.writes);
+            printf("buffer_cache = %d hits, %d misses\n", psinfo.cache_hits, psinfo.cache_misses);
+            printf("disk = %d blocks read, %d written\n", psinfo.cache_misses, psinfo.disk_writes);
+            printf("log = %d blocks\n", psinfo.log_blocks);
+            printf("page_faults = %d minor, %d zero-fill, %d cow, %d page cache, %d bad\n",
+                   psinfo.minor_faults, psinfo.zero_faults, psinfo.cow_faults, psinfo.cache_faults,
+                   psinfo.bad_faults);
+            printf("last_cpu = %d\n", psinfo.last_cpu);
+            printf("cpumask = 0x%x\n", psinfo.cpumask);
+            printf("utime = ");
+            print_us(psinfo.utime_us);
+            printf(" s\nstime = ");
+            print_us(psinfo.stime_us);
+            printf(" s\nwait_time = ");
+            print_us(psinfo.wait_us);
+            printf(" s\n");
+            printf("\n");
+        }
 
-            else {
+    }
+
+    // =================== ps top ===================
+    else if (!strcmp(argv[1], "top")) {
+
+        if (argc > 4) {
+            printf("incorrect arguments for ps top\n");
+            exit(1);
+        }
+        int ticks = argc > 2 ? atoi(argv[2]) : 10;
+        int count = argc > 3 ? atoi(argv[3]) : -1;  // forever
+        if (ticks <= 0) {
+            printf("ps top: ticks must be positive\n");
+            exit(1);
+        }
 
-                printf("info about pid = %d:\n", my_pids[i]);
-                printf("state = %s\n", psinfo.state);
-                printf("parent_id = %d\n", psinfo.parent_pid);
-                printf("mem_size = %d bytes\n", psinfo.mem_size);
-                printf("files_count = %d\n", psinfo.files_count);
-                printf("proc_name = %s\n", psinfo.proc_name);
-                printf("proc_ticks = %d\n", psinfo.proc_ticks);
-                printf("run_time = %d\n", psinfo.run_time);
-                printf("context_switches = %d\n", psinfo.context_switches);
-                printf("ps_info return value = %d\n", res);
-                printf("\n");
+        // two snapshots, swapped each time round.
+        struct process_info* cur = malloc(NPROC * sizeof(struct process_info));
+        struct process_info* prev = malloc(NPROC * sizeof(struct process_info));
+        struct screen s;
+        s.cap = (NPROC + 4) * 80;
+        s.buf = malloc(s.cap);
+        if (cur == 0 || prev == 0 || s.buf == 0) {
+            printf("ps: out of memory\n");
+            exit(1);
+        }
 
+        int nprev = ps_snapshot(prev, NPROC, 0);
+        uint64 tprev = nanotime();
+        if (nprev < 0) {
+            printf("ps_snapshot: internal error\n");
+            exit(-1);
+        }
+
+        for (int i = 0; count < 0 || i < count; ++i) {
+            sleep(ticks);
+
+            int ncur = ps_snapshot(cur, NPROC, 0);
+            uint64 tcur = nanotime();
+            if (ncur < 0) {
+                printf("ps_snapshot: internal error\n");
+                exit(-1);
+            }
+            if (ncur > NPROC) {
+                ncur = NPROC;
+            }
+            if (nprev > NPROC) {
+                nprev = NPROC;
             }
+
+            top_screen(&s, cur, ncur, prev, nprev, (tcur - tprev) / 1000, ticks);
+            write(1, s.buf, s.len);
+
+            struct process_info* t = prev;
+            prev = cur;
+            cur = t;
+            nprev = ncur;
+            tprev = tcur;
         }
 
+        free(cur);
+        free(prev);
+        free(s.buf);
+
     }
 
     // =================== ps pt ... ===================
@@ -290,7 +606,7 @@ main(int argc, char* argv[]) {
         }
         
         int pid = atoi(argv[2]);
-        uint64 addr = atoi(argv[3]);
+        uint64 addr = parse_uint(argv[3]);
         int size = atoi(argv[4]);
         
         char* data = (char*) malloc(size);
@@ -319,6 +635,9 @@ main(int argc, char* argv[]) {
     }
     
     // =================== ps sleep-write ===================
+    // what a process asleep in write() is writing: found with
+    // ps_blocked() and read with process_vm_readv(), so the
+    // process is not disturbed.
     else if (!strcmp(argv[1], "sleep-write")) {
       
         if (argc != 3) {
@@ -326,66 +645,304 @@ main(int argc, char* argv[]) {
             exit(1);
         }
         
-        int limit_size = 1024;  // simplified the task here
+        int limit_size = 1024;  // shows at most this much of the buffer
         int pid = atoi(argv[2]);
+
+        struct blocked_info* blocked = (struct blocked_info*) malloc(NPROC * sizeof(struct blocked_info));
         char* data = (char*) malloc(limit_size);
-        
-        int syscall = ps_sleep_write(pid, (void*) data);
-        
-        if (syscall == 0) {
-            printf("the process in not asleep\n");
+        if (blocked == 0 || data == 0) {
+            printf("cannot allocate enough memory for blocked processes\n");
+            exit(-1);
+        }
+
+        int n = ps_blocked(blocked, NPROC);
+        if (n < 0) {
+            printf("ps_blocked: internal error\n");
+            exit(-1);
         }
-        else if (syscall == -2) {
-            printf("pid not found\n");
+
+        struct blocked_info* b = 0;
+        for (int i = 0; i < n; ++i) {
+            if (blocked[i].pid == pid) {
+                b = &blocked[i];
+            }
         }
-        else if (syscall == -3) {
-            printf("pid is not assigned to any process at the moment\n");
+
+        struct process_info info;
+        if (b == 0) {
+            int res = ps_info(pid, &info);
+            if (res == -1) {
+                printf("pid not found\n");
+            }
+            else if (res == -2) {
+                printf("pid is not assigned to any process at the moment\n");
+            }
+            else {
+                printf("the process in not asleep\n");
+            }
         }
-        else if (syscall > 0) {
+        else {
             printf("the process fell asleep on syscall ");
-            print_syscall_name(syscall);
+            print_syscall_name(b->syscall);
             printf("\n");
-            if (syscall == SYS_write) {  // write
-            
-              int fd = *((int*) data);
-              data += sizeof(int);
+            if (b->syscall == SYS_write) {  // write(fd, buf, n)
+
+              int fd = (int) b->args[0];
               printf("file descriptor: %d\n", fd);
-              
-              int buf_size = *((int*) data);
-              data += sizeof(int);
+
+              int buf_size = (int) b->args[2];
               printf("buffer size: %d\n", buf_size);
-              
-             for (int i = 0; i < buf_size / 16; ++i) {
-               
-               for (int j = 0; j < 16; ++j) {
-                 printf("%s", data[j]);
-               }
-               
-               printf(" ");
-               
-               for (int j = 0; j < 16; ++j) {
-                 printf("%x", data[j]);
-                 if (j % 4 == 0) {
-                   printf(" ");
-                 }
-               }
-               
-               printf("\n");
-               
-               data += 16 * sizeof(char);
-             }
-              
+              if (buf_size > limit_size) {
+                  buf_size = limit_size;
+              }
+
+              struct iovec local = { (uint64) data, buf_size };
+              struct iovec remote = { b->args[1], buf_size };
+              int got = process_vm_readv(pid, &local, 1, &remote, 1);
+              if (got < 0) {
+                  printf("process_vm_readv: cannot read the buffer\n");
+              }
+              for (int i = 0; i < got; i++) {
+                  printf("%x ", data[i] & 0xff);
+                  if (i % 16 == 15 || i == got - 1) {
+                      printf("\n");
+                  }
+              }
+
             }
         }
-        else {
-            printf("ps_sleep_write: internal error\n");
-        }
-        
+
         free(data);
+        free(blocked);
     
     }
     
     
+    // =================== ps blocked ===================
+    else if (!strcmp(argv[1], "blocked")) {
+
+        if (argc != 2) {
+            printf("incorrect arguments for ps blocked\n");
+            exit(1);
+        }
+
+        struct blocked_info* blocked = (struct blocked_info*) malloc(NPROC * sizeof(struct blocked_info));
+        if (blocked == 0) {
+            printf("cannot allocate enough memory for blocked processes\n");
+            exit(-1);
+        }
+
+        int n = ps_blocked(blocked, NPROC);
+        if (n < 0) {
+            printf("ps_blocked: internal error\n");
+            exit(-1);
+        }
+
+        printf("pid\tname\tblocked\t\tcall\t\twaiting for\n");
+        for (int i = 0; i < n; ++i) {
+            struct blocked_info* b = &blocked[i];
+            printf("%d\t%s\t", b->pid, b->name);
+            print_us(b->blocked_us);
+            printf("\t");
+            print_blocked_call(b);
+            printf("\t");
+            print_wchan(b->wchan, b->wchan_arg);
+            if (b->lock_holder != 0) {
+                printf(", held by pid %d", b->lock_holder);
+            }
+            printf("\n");
+        }
+
+        free(blocked);
+
+    }
+
+
+    // =================== ps affinity ===================
+    else if (!strcmp(argv[1], "affinity")) {
+
+        if (argc != 3 && argc != 4) {
+            printf("incorrect arguments for ps affinity\n");
+            exit(1);
+        }
+
+        int pid = atoi(argv[2]);
+
+        if (argc == 4) {
+            uint mask = parse_uint(argv[3]);
+            if (sched_setaffinity(pid, mask) != 0) {
+                printf("sched_setaffinity: cannot set mask 0x%x for pid %d\n", mask, pid);
+                exit(1);
+            }
+        }
+
+        uint mask = 0;
+        if (sched_getaffinity(pid, &mask) != 0) {
+            printf("sched_getaffinity: cannot get mask for pid %d\n", pid);
+            exit(1);
+        }
+
+        printf("pid %d cpumask = 0x%x\n", pid, mask);
+
+    }
+
+
+    // =================== ps maps ===================
+    else if (!strcmp(argv[1], "maps")) {
+
+        if (argc != 3) {
+            printf("incorrect arguments for ps maps\n");
+            exit(1);
+        }
+        int pid = atoi(argv[2]);
+
+        // ask again with more room if the first guess was short.
+        int max = 64;
+        struct pt_map* maps = 0;
+        int n;
+        for (;;) {
+            maps = (struct pt_map*) malloc(max * sizeof(struct pt_map));
+            if (maps == 0) {
+                printf("cannot allocate enough memory for maps\n");
+                exit(-1);
+            }
+            n = ps_pt_walk(pid, maps, max);
+            if (n <= max) {
+                break;
+            }
+            free(maps);
+            max = n;
+        }
+        if (n < 0) {
+            printf("ps_pt_walk: cannot walk pid %d\n", pid);
+            exit(-1);
+        }
+
+        printf("va\t\t\t\tpa\t\t\tsize\tperm\tlevel\n");
+        for (int i = 0; i < n; ++i) {
+            struct pt_map* m = &maps[i];
+            printf("%p-%p %p %dK\t%c%c%c%c\t%d", m->va, m->va + m->len, m->pa, (int) (m->len / 1024),
+                   (m->flags & PTE_R) ? 'r' : '-', (m->flags & PTE_W) ? 'w' : '-',
+                   (m->flags & PTE_X) ? 'x' : '-', (m->flags & PTE_U) ? 'u' : '-', m->level);
+            if (m->va == TRAMPOLINE) {
+                printf("\t[trampoline]");
+            } else if (m->va == TRAPFRAME) {
+                printf("\t[trapframe]");
+            } else if (m->va == VDSO) {
+                printf("\t[vdso]");
+            } else if (m->va >= THREADFRAME(NPROC - 1) && m->va < VDSO) {
+                printf("\t[threadframe]");
+            } else if (m->va == RING) {
+                printf("\t[ring]");
+            }
+            printf("\n");
+        }
+
+        free(maps);
+
+    }
+
+
+    // =================== ps cpus ===================
+    else if (!strcmp(argv[1], "cpus")) {
+
+        if (argc != 2) {
+            printf("incorrect arguments for ps cpus\n");
+            exit(1);
+        }
+
+        struct cpu_info cpus[NCPU];
+        int ncpu = ps_cpus(cpus, NCPU);
+        if (ncpu < 0) {
+            printf("ps_cpus: internal error\n");
+            exit(-1);
+        }
+
+        printf("cpu\tpid\ttlb_sent\ttlb_recv\n");
+        for (int i = 0; i < ncpu && i < NCPU; ++i) {
+            printf("%d\t%d\t%l\t\t%l\n", cpus[i].cpu, cpus[i].pid, cpus[i].tlb_sent, cpus[i].tlb_recv);
+        }
+
+    }
+
+
+    // =================== ps syscalls ===================
+    else if (!strcmp(argv[1], "syscalls")) {
+
+        if (argc > 3 || (argc == 3 && strcmp(argv[2], "-h"))) {
+            printf("incorrect arguments for ps syscalls\n");
+            exit(1);
+        }
+        int h = (argc == 3) ? 1 : 0;
+
+        struct syscall_stat* stats = (struct syscall_stat*) malloc(NSYSSTAT * sizeof(struct syscall_stat));
+        if (stats == 0) {
+            printf("cannot allocate enough memory for syscall stats\n");
+            exit(-1);
+        }
+
+        int n = ps_syscalls(stats, NSYSSTAT);
+        if (n < 0) {
+            printf("ps_syscalls: internal error\n");
+            exit(-1);
+        }
+
+        printf("syscall\t\tcalls\terrors\tavg_ns\n");
+        for (int i = 0; i < n; ++i) {
+            struct syscall_stat* s = &stats[i];
+            if (s->calls == 0) {
+                continue;
+            }
+            print_syscall_name(i);
+            printf("\t\t%d\t%d\t%l\n", (int) s->calls, (int) s->errors, cycles_ns(s->lat.cycles) / s->calls);
+
+            // latency histogram: calls under each power of two
+            if (h) {
+                print_lathist(&s->lat);
+            }
+        }
+
+        free(stats);
+
+    }
+
+
+    // =================== ps faults ===================
+    else if (!strcmp(argv[1], "faults")) {
+
+        if (argc != 2) {
+            printf("incorrect arguments for ps faults\n");
+            exit(1);
+        }
+
+        struct fault_stat s;
+        if (ps_faults(&s) != 0) {
+            printf("ps_faults: internal error\n");
+            exit(-1);
+        }
+
+        char* kinds[NFAULT] = {
+          [FAULT_MINOR] "minor",
+          [FAULT_ZERO] "zero-fill",
+          [FAULT_COW] "cow",
+          [FAULT_PAGECACHE] "page cache",
+          [FAULT_BAD] "bad",
+        };
+        uint64 total = 0;
+        for (int k = 0; k < NFAULT; ++k) {
+            printf("%s\t%l\n", kinds[k], s.faults[k]);
+            total += s.faults[k];
+        }
+        if (total == 0) {
+            exit(0);
+        }
+
+        printf("avg_ns\t%l\n", cycles_ns(s.lat.cycles) / total);
+        print_lathist(&s.lat);
+
+    }
+
+
     // =================== unknown cmd ===================
     else {
 
@@ -0,0 +1,92 @@
+// Compares writing a file with one write() per block against
+// queueing the writes on a system call ring and submitting
+// them in batches with ring_enter().
+//
+// usage: ringbench [blocks [batch]]
+
+#include "kernel/types.h"
+#include "kernel/fcntl.h"
+#include "kernel/syscall.h"
+#include "kernel/ring.h"
+#include "user/user.h"
+
+#define BSIZE 64
+
+char buf[BSIZE];
+
+int
+main(int argc, char *argv[])
+{
+  int blocks = 2000, batch = 32;
+  struct ring *r;
+  uint64 t0, t1, t2;
+  int fd, i, n;
+
+  if(argc > 1)
+    blocks = atoi(argv[1]);
+  if(argc > 2)
+    batch = atoi(argv[2]);
+  if(batch < 1 || batch > RING_SIZE){
+    fprintf(2, "ringbench: batch must be 1..%d\n", RING_SIZE);
+    exit(1);
+  }
+  if((r = ring_setup()) == (struct ring*)-1){
+    fprintf(2, "ringbench: ring_setup failed\n");
+    exit(1);
+  }
+  memset(buf, 'x', BSIZE);
+
+  // one system call per block.
+  if((fd = open("ringbench.tmp", O_CREATE | O_TRUNC | O_WRONLY)) < 0){
+    fprintf(2, "ringbench: cannot create ringbench.tmp\n");
+    exit(1);
+  }
+  t0 = nanotime();
+  for(i = 0; i < blocks; i++){
+    if(write(fd, buf, BSIZE) != BSIZE){
+      fprintf(2, "ringbench: write failed\n");
+      exit(1);
+    }
+  }
+  t1 = nanotime();
+  close(fd);
+
+  // the same writes, batch at a time on the ring.
+  if((fd = open("ringbench.tmp", O_CREATE | O_TRUNC | O_WRONLY)) < 0){
+    fprintf(2, "ringbench: cannot create ringbench.tmp\n");
+    exit(1);
+  }
+  t1 = t1 - t0;
+  t0 = nanotime();
+  for(i = 0; i < blocks; i += n){
+    n = blocks - i < batch ? blocks - i : batch;
+    for(int k = 0; k < n; k++){
+      struct ring_sqe *e = &r->sq[(r->sq_tail + k) % RING_SIZE];
+      e->op = SYS_write;
+      e->args[0] = fd;
+      e->args[1] = (uint64)buf;
+      e->args[2] = BSIZE;
+      e->user_data = i + k;
+    }
+    __sync_synchronize();
+    r->sq_tail += n;
+    if(ring_enter(n) != n){
+      fprintf(2, "ringbench: ring_enter failed\n");
+      exit(1);
+    }
+    for(; r->cq_head != r->cq_tail; r->cq_head++){
+      if(r->cq[r->cq_head % RING_SIZE].res != BSIZE){
+        fprintf(2, "ringbench: queued write failed\n");
+        exit(1);
+      }
+    }
+  }
+  t2 = nanotime() - t0;
+  close(fd);
+  unlink("ringbench.tmp");
+
+  printf("ringbench: %d writes of %d bytes\n", blocks, BSIZE);
+  printf("  write():      %d us\n", (int)(t1 / 1000));
+  printf("  ring batch %d: %d us\n", batch, (int)(t2 / 1000));
+  exit(0);
+}
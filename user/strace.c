@@ -0,0 +1,175 @@
+// Logs the system calls a process makes: their arguments,
+// return values and how long they took. The process is not
+// stopped; records are read while it runs.
+//
+// usage: strace [-c] [-e call,...] cmd args...
+//        strace [-c] [-e call,...] -p pid
+//
+// -c prints a summary per system call when the process exits
+// instead of each call, -e traces only the calls named.
+
+#include "kernel/types.h"
+#include "kernel/syscall.h"
+#include "kernel/strace.h"
+#include "user/user.h"
+
+#define NREC   64
+
+// for -c.
+struct {
+  int calls;
+  int errors;
+  uint64 cycles;
+} sum[NSYSNAME];
+
+struct strace_rec recs[NREC];
+
+static void
+print_us(uint64 cycles)
+{
+  uint64 us = cycles_us(cycles);
+  printf("%d.%d%d%d ms", (int)(us / 1000),
+         (int)(us / 100 % 10), (int)(us / 10 % 10), (int)(us % 10));
+}
+
+static void
+print_rec(struct strace_rec *r)
+{
+  int i, nargs = 6;
+
+  if(syscall_name(r->num)){
+    printf("%s(", syscall_name(r->num));
+    nargs = sysnames[r->num].nargs;
+  } else {
+    printf("syscall_%d(", r->num);
+  }
+  for(i = 0; i < nargs; i++)
+    printf(i ? ", %p" : "%p", r->args[i]);
+  printf(") = %d  <", (int)r->ret);
+  print_us(r->cycles);
+  printf(">\n");
+}
+
+static void
+print_summary(void)
+{
+  int num;
+
+  printf("calls\terrors\ttotal\t\tsystem call\n");
+  for(num = 0; num < NSYSNAME; num++){
+    if(sum[num].calls == 0)
+      continue;
+    printf("%d\t%d\t", sum[num].calls, sum[num].errors);
+    print_us(sum[num].cycles);
+    if(syscall_name(num))
+      printf("\t%s\n", syscall_name(num));
+    else
+      printf("\tsyscall_%d\n", num);
+  }
+}
+
+// the mask for a comma-separated list of call names.
+static uint64
+parse_calls(char *list)
+{
+  uint64 mask = 0;
+  char *p, *q;
+  int num;
+
+  for(p = list; *p; p = q){
+    if((q = strchr(p, ',')) != 0)
+      *q++ = 0;
+    else
+      q = p + strlen(p);
+    for(num = 0; num < NSYSNAME; num++)
+      if(syscall_name(num) && strcmp(syscall_name(num), p) == 0)
+        break;
+    if(num == NSYSNAME){
+      fprintf(2, "strace: unknown system call %s\n", p);
+      exit(1);
+    }
+    mask |= 1L << num;
+  }
+  return mask;
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: strace [-c] [-e call,...] cmd args... | -p pid\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint64 mask = -1;
+  uint64 seq = 0;
+  int summary = 0, pid = 0;
+  int n, i;
+
+  for(argc--, argv++; argc > 0 && argv[0][0] == '-'; argc--, argv++){
+    if(strcmp(argv[0], "-c") == 0){
+      summary = 1;
+    } else if(strcmp(argv[0], "-e") == 0 && argc > 1){
+      mask = parse_calls(argv[1]);
+      argc--, argv++;
+    } else if(strcmp(argv[0], "-p") == 0 && argc > 1){
+      pid = atoi(argv[1]);
+      argc--, argv++;
+    } else {
+      usage();
+    }
+  }
+
+  if(pid != 0){
+    if(argc != 0)
+      usage();
+    if(trace(pid, mask) < 0){
+      fprintf(2, "strace: cannot trace %d\n", pid);
+      exit(1);
+    }
+  } else {
+    if(argc == 0)
+      usage();
+    if((pid = fork()) < 0){
+      fprintf(2, "strace: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      trace(0, mask);
+      exec(argv[0], argv);
+      fprintf(2, "strace: exec %s failed\n", argv[0]);
+      exit(1);
+    }
+  }
+
+  // poll until the process has exited and everything it
+  // logged has been read.
+  while((n = trace_read(pid, recs, NREC)) >= 0){
+    if(n == 0){
+      nanosleep(1000000);
+      continue;
+    }
+    for(i = 0; i < n; i++){
+      struct strace_rec *r = &recs[i];
+      if(r->seq != seq)
+        printf("... %d calls lost\n", (int)(r->seq - seq));
+      seq = r->seq + 1;
+      if(!summary){
+        print_rec(r);
+      } else if(r->num > 0 && r->num < NSYSNAME){
+        sum[r->num].calls++;
+        if((long)r->ret < 0)
+          sum[r->num].errors++;
+        sum[r->num].cycles += r->cycles;
+      }
+    }
+  }
+
+  if(summary)
+    print_summary();
+  if(argc > 0)
+    wait(0);
+  exit(0);
+}
@@ -0,0 +1,71 @@
+// Names and argument counts of the system calls, indexed by
+// their SYS_* numbers, for the tools that print calls.
+
+#include "kernel/types.h"
+#include "kernel/syscall.h"
+#include "user/user.h"
+
+struct sysname sysnames[NSYSNAME] = {
+  [SYS_fork]              { "fork", 0 },
+  [SYS_exit]              { "exit", 1 },
+  [SYS_wait]              { "wait", 1 },
+  [SYS_pipe]              { "pipe", 1 },
+  [SYS_read]              { "read", 3 },
+  [SYS_kill]              { "kill", 1 },
+  [SYS_exec]              { "exec", 2 },
+  [SYS_fstat]             { "fstat", 2 },
+  [SYS_chdir]             { "chdir", 1 },
+  [SYS_dup]               { "dup", 1 },
+  [SYS_getpid]            { "getpid", 0 },
+  [SYS_sbrk]              { "sbrk", 1 },
+  [SYS_sleep]             { "sleep", 1 },
+  [SYS_uptime]            { "uptime", 0 },
+  [SYS_open]              { "open", 2 },
+  [SYS_write]             { "write", 3 },
+  [SYS_mknod]             { "mknod", 3 },
+  [SYS_unlink]            { "unlink", 1 },
+  [SYS_link]              { "link", 2 },
+  [SYS_mkdir]             { "mkdir", 1 },
+  [SYS_close]             { "close", 1 },
+  [SYS_dummy]             { "dummy", 0 },
+  [SYS_ps_list]           { "ps_list", 2 },
+  [SYS_ps_info]           { "ps_info", 2 },
+  [SYS_ps_pt0]            { "ps_pt0", 2 },
+  [SYS_ps_pt1]            { "ps_pt1", 3 },
+  [SYS_ps_pt2]            { "ps_pt2", 3 },
+  [SYS_ps_copy]           { "ps_copy", 4 },
+  [SYS_sched_setaffinity] { "sched_setaffinity", 2 },
+  [SYS_sched_getaffinity] { "sched_getaffinity", 2 },
+  [SYS_clone]             { "clone", 4 },
+  [SYS_join]              { "join", 1 },
+  [SYS_futex]             { "futex", 3 },
+  [SYS_ps_cpus]           { "ps_cpus", 2 },
+  [SYS_nanosleep]         { "nanosleep", 1 },
+  [SYS_ring_setup]        { "ring_setup", 0 },
+  [SYS_ring_enter]        { "ring_enter", 1 },
+  [SYS_ps_syscalls]       { "ps_syscalls", 2 },
+  [SYS_ktrace_ctl]        { "ktrace_ctl", 1 },
+  [SYS_ktrace_read]       { "ktrace_read", 2 },
+  [SYS_prof_ctl]          { "prof_ctl", 1 },
+  [SYS_prof_read]         { "prof_read", 2 },
+  [SYS_trace]             { "trace", 2 },
+  [SYS_trace_read]        { "trace_read", 3 },
+  [SYS_ps_snapshot]       { "ps_snapshot", 3 },
+  [SYS_process_vm_readv]  { "process_vm_readv", 5 },
+  [SYS_process_vm_writev] { "process_vm_writev", 5 },
+  [SYS_ps_pt_walk]        { "ps_pt_walk", 3 },
+  [SYS_ps_blocked]        { "ps_blocked", 2 },
+  [SYS_ps_faults]         { "ps_faults", 1 },
+  [SYS_lockstat_ctl]      { "lockstat_ctl", 1 },
+  [SYS_lockstat_read]     { "lockstat_read", 2 },
+  [SYS_lockbench]         { "lockbench", 2 },
+};
+
+// the name of system call num, or 0 if there is none.
+char*
+syscall_name(int num)
+{
+  if(num <= 0 || num >= NSYSNAME)
+    return 0;
+  return sysnames[num].name;
+}
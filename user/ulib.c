@@ -1,6 +1,9 @@
 #include "kernel/types.h"
 #include "kernel/stat.h"
 #include "kernel/fcntl.h"
+#include "kernel/riscv.h"
+#include "kernel/memlayout.h"
+#include "kernel/vdso.h"
 #include "user/user.h"
 
 //
@@ -145,3 +148,53 @@ memcpy(void *dst, const void *src, uint n)
 {
   return memmove(dst, src, n);
 }
+
+// getpid(), uptime() and nanotime() read the kernel's vdso
+// page instead of making a system call when they can.
+
+int _getpid(void);
+int _uptime(void);
+
+int
+getpid(void)
+{
+  struct vdso *v = (struct vdso*)VDSO;
+
+  // threads share the page.
+  if(v->shared)
+    return _getpid();
+  return v->pid;
+}
+
+int
+uptime(void)
+{
+  struct vdso *v = (struct vdso*)VDSO;
+
+  if(v->tick_interval == 0)
+    return _uptime();
+  return r_time() / v->tick_interval;
+}
+
+// nanoseconds since boot.
+uint64
+nanotime(void)
+{
+  struct vdso *v = (struct vdso*)VDSO;
+
+  return (r_time() * v->ns_mult) >> v->ns_shift;
+}
+
+// time CSR cycles, as the kernel counts them, in nanoseconds
+// and in microseconds.
+uint64
+cycles_ns(uint64 cycles)
+{
+  return cycles * 1000 / (TIMEBASE / 1000000);
+}
+
+uint64
+cycles_us(uint64 cycles)
+{
+  return cycles / (TIMEBASE / 1000000);
+}
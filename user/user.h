@@ -1,5 +1,16 @@
 struct stat;
 struct process_info;
+struct cpu_info;
+struct ring;
+struct syscall_stat;
+struct trace_rec;
+struct prof_sample;
+struct strace_rec;
+struct iovec;
+struct pt_map;
+struct blocked_info;
+struct fault_stat;
+struct lock_stat;
 
 // system calls
 int fork(void);
@@ -30,7 +41,31 @@ int ps_pt0(int, uint64*);
 int ps_pt1(int, uint64*, void*);
 int ps_pt2(int, uint64*, void*);
 int ps_copy(int, void*, int, void*);
-int ps_sleep_write(int, void*);
+int sched_setaffinity(int, uint);
+int sched_getaffinity(int, uint*);
+int clone(void (*)(void*, void*), void*, void*, void*);
+int join(int);
+int futex(int*, int, int);
+int ps_cpus(struct cpu_info*, int);
+int nanosleep(uint64);
+struct ring* ring_setup(void);
+int ring_enter(int);
+int ps_syscalls(struct syscall_stat*, int);
+int ktrace_ctl(int);
+int ktrace_read(struct trace_rec*, int);
+int prof_ctl(int);
+int prof_read(struct prof_sample*, int);
+int trace(int, uint64);
+int trace_read(int, struct strace_rec*, int);
+int ps_snapshot(struct process_info*, int, uint64*);
+int process_vm_readv(int, struct iovec*, int, struct iovec*, int);
+int process_vm_writev(int, struct iovec*, int, struct iovec*, int);
+int ps_pt_walk(int, struct pt_map*, int);
+int ps_blocked(struct blocked_info*, int);
+int ps_faults(struct fault_stat*);
+int lockstat_ctl(int);
+int lockstat_read(struct lock_stat*, int);
+int lockbench(int, int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -48,3 +83,32 @@ void free(void*);
 int atoi(const char*);
 int memcmp(const void *, const void *, uint);
 void *memcpy(void *, const void *, uint);
+uint64 nanotime(void);
+uint64 cycles_ns(uint64);
+uint64 cycles_us(uint64);
+
+// sysnames.c
+#define NSYSNAME 64  // system call numbers named, 0..NSYSNAME-1
+struct sysname {
+  char *name;
+  int nargs;
+};
+extern struct sysname sysnames[NSYSNAME];
+char* syscall_name(int);
+
+// uthread.c
+struct mutex {
+  int state;  // 0 unlocked, 1 locked, 2 locked and maybe waited on
+};
+struct cond {
+  int seq;    // bumped by every signal
+};
+int thread_create(void (*)(void*), void*);
+int thread_join(int);
+void mutex_init(struct mutex*);
+void mutex_lock(struct mutex*);
+void mutex_unlock(struct mutex*);
+void cond_init(struct cond*);
+void cond_wait(struct cond*, struct mutex*);
+void cond_signal(struct cond*);
+void cond_broadcast(struct cond*);
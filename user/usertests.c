@@ -4,6 +4,18 @@
 #include "user/user.h"
 #include "kernel/fs.h"
 #include "kernel/fcntl.h"
+#include "kernel/futex.h"
+#include "kernel/ring.h"
+#include "kernel/strace.h"
+#include "kernel/process_info.h"
+#include "kernel/iovec.h"
+#include "kernel/ptmap.h"
+#include "kernel/wchan.h"
+#include "kernel/blocked_info.h"
+#include "kernel/lathist.h"
+#include "kernel/fault.h"
+#include "kernel/lockstat.h"
+#include "kernel/spinlock.h"
 #include "kernel/syscall.h"
 #include "kernel/memlayout.h"
 #include "kernel/riscv.h"
@@ -2571,6 +2583,628 @@ badarg(char *s)
   exit(0);
 }
 
+// threads made by clone() share memory with their creator,
+// including memory that one of them sbrk()s later.
+volatile int clonesum;
+volatile char *clonemem;
+
+void
+clonechild(void *arg)
+{
+  __sync_fetch_and_add(&clonesum, (int)(uint64)arg);
+  if((uint64)arg == 1){
+    char *p = sbrk(4096);
+    if(p == (char*)0xffffffffffffffffL)
+      exit(1);
+    p[0] = 'x';
+    clonemem = p;
+  }
+}
+
+void
+clonetest(char *s)
+{
+  int tids[4];
+
+  clonesum = 0;
+  clonemem = 0;
+  for(int i = 0; i < 4; i++){
+    if((tids[i] = thread_create(clonechild, (void*)(uint64)(i+1))) < 0){
+      printf("%s: thread_create failed\n", s);
+      exit(1);
+    }
+  }
+  for(int i = 0; i < 4; i++){
+    if(thread_join(tids[i]) != tids[i]){
+      printf("%s: thread_join wrong tid\n", s);
+      exit(1);
+    }
+  }
+  if(clonesum != 1+2+3+4){
+    printf("%s: threads don't share memory\n", s);
+    exit(1);
+  }
+  if(clonemem == 0 || clonemem[0] != 'x'){
+    printf("%s: sbrk() in a thread not visible\n", s);
+    exit(1);
+  }
+  if(join(0) != -1 || wait(0) != -1){
+    printf("%s: join/wait found a child\n", s);
+    exit(1);
+  }
+}
+
+// threads contending for a futex-based mutex, and handing
+// work over through a condition variable.
+struct mutex futexmu;
+struct cond futexcv;
+volatile int futexcount;
+volatile int futexready;
+
+void
+futexchild(void *arg)
+{
+  for(int i = 0; i < 1000; i++){
+    mutex_lock(&futexmu);
+    futexcount = futexcount + 1;
+    mutex_unlock(&futexmu);
+  }
+  mutex_lock(&futexmu);
+  futexready++;
+  cond_signal(&futexcv);
+  mutex_unlock(&futexmu);
+}
+
+void
+futextest(char *s)
+{
+  int tids[4];
+
+  mutex_init(&futexmu);
+  cond_init(&futexcv);
+  futexcount = 0;
+  futexready = 0;
+  for(int i = 0; i < 4; i++){
+    if((tids[i] = thread_create(futexchild, 0)) < 0){
+      printf("%s: thread_create failed\n", s);
+      exit(1);
+    }
+  }
+  mutex_lock(&futexmu);
+  while(futexready < 4)
+    cond_wait(&futexcv, &futexmu);
+  mutex_unlock(&futexmu);
+  for(int i = 0; i < 4; i++)
+    thread_join(tids[i]);
+  if(futexcount != 4000){
+    printf("%s: lost updates, count %d\n", s, futexcount);
+    exit(1);
+  }
+  if(futex((int*)&futexcount, FUTEX_WAIT, 0) != -1){
+    printf("%s: FUTEX_WAIT slept with a stale value\n", s);
+    exit(1);
+  }
+}
+
+// nanosleep() sleeps at least as long as asked.
+void
+nanosleeptest(char *s)
+{
+  if(nanosleep(0) != 0){
+    printf("%s: nanosleep(0) failed\n", s);
+    exit(1);
+  }
+  int t0 = uptime();
+  for(int i = 0; i < 100; i++)
+    nanosleep(1000000);  // 1ms
+  int t1 = uptime();
+  nanosleep(250000000);  // 2.5 ticks
+  int t2 = uptime();
+  if(t2 - t1 < 2){
+    printf("%s: nanosleep woke after %d ticks\n", s, t2 - t1);
+    exit(1);
+  }
+  if(t1 - t0 < 1){
+    printf("%s: 100 1ms sleeps took %d ticks\n", s, t1 - t0);
+    exit(1);
+  }
+}
+
+// getpid() and uptime() answered from the vdso page
+// agree with the kernel.
+void
+vdsotest(char *s)
+{
+  int ppid = getpid();
+  int pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(getpid());
+  int xstatus;
+  wait(&xstatus);
+  if(xstatus != pid || getpid() != ppid){
+    printf("%s: wrong pid\n", s);
+    exit(1);
+  }
+
+  uint64 ns0 = nanotime();
+  int t0 = uptime();
+  sleep(1);
+  if(uptime() <= t0 || nanotime() <= ns0){
+    printf("%s: time went backwards\n", s);
+    exit(1);
+  }
+}
+
+// queued system calls run in order and report their
+// results; disallowed ones fail.
+void
+ringtest(char *s)
+{
+  struct ring *r = ring_setup();
+  int fds[2];
+  char c = 0;
+
+  if(r == (struct ring*)-1 || pipe(fds) < 0){
+    printf("%s: ring_setup or pipe failed\n", s);
+    exit(1);
+  }
+  uint t = r->sq_tail;
+  struct ring_sqe *e = &r->sq[t % RING_SIZE];
+  e->op = SYS_write; e->args[0] = fds[1]; e->args[1] = (uint64)"r"; e->args[2] = 1;
+  e->user_data = 1;
+  e = &r->sq[(t+1) % RING_SIZE];
+  e->op = SYS_read; e->args[0] = fds[0]; e->args[1] = (uint64)&c; e->args[2] = 1;
+  e->user_data = 2;
+  e = &r->sq[(t+2) % RING_SIZE];
+  e->op = SYS_fork;
+  e->user_data = 3;
+  r->sq_tail = t + 3;
+
+  if(ring_enter(3) != 3 || r->cq_tail - r->cq_head != 3){
+    printf("%s: ring_enter didn't run 3 calls\n", s);
+    exit(1);
+  }
+  for(uint64 i = 1; i <= 3; i++){
+    struct ring_cqe *q = &r->cq[r->cq_head++ % RING_SIZE];
+    if(q->user_data != i || q->res != (i == 3 ? -1 : 1)){
+      printf("%s: completion %d: res %d\n", s, (int)i, (int)q->res);
+      exit(1);
+    }
+  }
+  if(c != 'r'){
+    printf("%s: queued read got %c\n", s, c);
+    exit(1);
+  }
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// trace() logs only the calls asked for, with their arguments
+// and return values.
+void
+stracetest(char *s)
+{
+  struct strace_rec r[4];
+  int fd, n;
+
+  if((fd = dup(1)) < 0 || trace(0, 1L << SYS_close) < 0){
+    printf("%s: dup or trace failed\n", s);
+    exit(1);
+  }
+  close(fd);
+  close(fd);
+  trace(0, 0);
+  n = trace_read(getpid(), r, 4);
+  if(n != 2){
+    printf("%s: trace_read returned %d, not 2\n", s, n);
+    exit(1);
+  }
+  if(r[0].num != SYS_close || r[0].args[0] != fd || r[0].ret != 0 ||
+     r[1].seq != 1 || (long)r[1].ret != -1){
+    printf("%s: wrong records\n", s);
+    exit(1);
+  }
+}
+
+// ps_snapshot() finds us, and its generation moves on
+// when a process comes and goes.
+void
+snapshottest(char *s)
+{
+  struct process_info *infos = malloc(NPROC * sizeof(*infos));
+  uint64 gen0, gen1;
+  int n, i, pid;
+
+  n = ps_snapshot(infos, NPROC, &gen0);
+  for(i = 0; i < n && i < NPROC; i++)
+    if(infos[i].pid == getpid())
+      break;
+  if(n <= 0 || i == n || i == NPROC || strcmp(infos[i].state, "run   ") != 0){
+    printf("%s: ps_snapshot didn't find us running\n", s);
+    exit(1);
+  }
+
+  if((pid = fork()) < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(0);
+  wait(0);
+  if(ps_snapshot(infos, NPROC, &gen1) != n || gen1 == gen0){
+    printf("%s: generation didn't change\n", s);
+    exit(1);
+  }
+  free(infos);
+}
+
+char vmbuf[8];
+
+// process_vm_readv() gathers across page boundaries and stops
+// short at an unmapped page; process_vm_writev() reaches into
+// another process.
+void
+vmcopytest(char *s)
+{
+  struct iovec l[2], r[2];
+  char *a = malloc(100), *b = malloc(2*PGSIZE);
+  char *src = sbrk(0);
+  int fds[2], pid, i, xstatus;
+
+  // two pages, with nothing mapped after them.
+  sbrk(PGROUNDUP((uint64)src) - (uint64)src);
+  src = sbrk(2*PGSIZE);
+  for(i = 0; i < 2*PGSIZE; i++)
+    src[i] = i % 251;
+
+  l[0].base = (uint64)a;   l[0].len = 100;
+  l[1].base = (uint64)b;   l[1].len = 2*PGSIZE - 100;
+  r[0].base = (uint64)src; r[0].len = PGSIZE + 50;
+  r[1].base = (uint64)src + PGSIZE + 50; r[1].len = PGSIZE - 50;
+  if(process_vm_readv(getpid(), l, 2, r, 2) != 2*PGSIZE){
+    printf("%s: process_vm_readv didn't copy two pages\n", s);
+    exit(1);
+  }
+  for(i = 0; i < 2*PGSIZE; i++){
+    if((i < 100 ? a[i] : b[i-100]) != (char)(i % 251)){
+      printf("%s: wrong byte %d\n", s, i);
+      exit(1);
+    }
+  }
+
+  r[0].base = (uint64)src + 2*PGSIZE - 10; r[0].len = 20;
+  if(process_vm_readv(getpid(), l, 1, r, 1) != 10){
+    printf("%s: process_vm_readv past the end didn't stop short\n", s);
+    exit(1);
+  }
+
+  if(pipe(fds) < 0 || (pid = fork()) < 0){
+    printf("%s: pipe or fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    read(fds[0], a, 1);
+    exit(strcmp(vmbuf, "hello") == 0 ? 0 : 1);
+  }
+  l[0].base = (uint64)"hello"; l[0].len = 6;
+  r[0].base = (uint64)vmbuf;   r[0].len = 6;
+  if(process_vm_writev(pid, l, 1, r, 1) != 6){
+    printf("%s: process_vm_writev failed\n", s);
+    exit(1);
+  }
+  write(fds[1], "x", 1);
+  wait(&xstatus);
+  if(xstatus != 0){
+    printf("%s: child didn't see the write\n", s);
+    exit(1);
+  }
+}
+
+// ps_pt_walk() reports our data as user-writable, and the
+// trampoline as kernel-only, in address order.
+void
+ptwalktest(char *s)
+{
+  struct pt_map *m = malloc(1024 * sizeof(*m));
+  uint64 data = (uint64)vmbuf;
+  int n, i, found = 0;
+
+  n = ps_pt_walk(getpid(), m, 1024);
+  if(n <= 0 || n > 1024){
+    printf("%s: ps_pt_walk returned %d\n", s, n);
+    exit(1);
+  }
+  for(i = 0; i < n; i++){
+    if(i > 0 && m[i].va < m[i-1].va + m[i-1].len){
+      printf("%s: runs out of order\n", s);
+      exit(1);
+    }
+    if(m[i].va <= data && data < m[i].va + m[i].len &&
+       (m[i].flags & (PTE_U|PTE_W)) == (PTE_U|PTE_W))
+      found |= 1;
+    if(m[i].va == TRAMPOLINE && (m[i].flags & (PTE_U|PTE_X)) == PTE_X)
+      found |= 2;
+  }
+  if(found != 3){
+    printf("%s: data or trampoline missing\n", s);
+    exit(1);
+  }
+  free(m);
+}
+
+// ps_info() counts the pages sbrk() maps and unmaps.
+void
+rsstest(char *s)
+{
+  struct process_info before, grown, after;
+
+  if(ps_info(getpid(), &before) != 0 || sbrk(10*PGSIZE) == (char*)-1 ||
+     ps_info(getpid(), &grown) != 0 || sbrk(-10*PGSIZE) == (char*)-1 ||
+     ps_info(getpid(), &after) != 0){
+    printf("%s: ps_info or sbrk failed\n", s);
+    exit(1);
+  }
+  if(grown.rss_pages < before.rss_pages + 10 || after.rss_pages > grown.rss_pages - 10){
+    printf("%s: rss %d, %d, %d\n", s, before.rss_pages, grown.rss_pages, after.rss_pages);
+    exit(1);
+  }
+  if(before.pt_pages < 3 || before.kernel_pages < 2 || before.shared_pages != 0){
+    printf("%s: wrong page-table, kernel or shared pages\n", s);
+    exit(1);
+  }
+}
+
+// process_info counts the system calls a process makes, failed
+// ones too.
+void
+syscallcounttest(char *s)
+{
+  struct process_info before, after;
+  int i;
+
+  if(ps_info(getpid(), &before) != 0){
+    printf("%s: ps_info failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < 10; i++)
+    close(-1);
+  if(ps_info(getpid(), &after) != 0){
+    printf("%s: ps_info failed\n", s);
+    exit(1);
+  }
+  if(after.syscalls - before.syscalls < 11){
+    printf("%s: %d system calls counted, not 11\n", s, after.syscalls - before.syscalls);
+    exit(1);
+  }
+}
+
+// process_info counts the bytes a process reads and writes, and
+// the blocks it puts in the log.
+void
+ioacctest(char *s)
+{
+  struct process_info before, after;
+  char buf[512];
+  int fd;
+
+  memset(buf, 'a', sizeof(buf));
+  if(ps_info(getpid(), &before) != 0){
+    printf("%s: ps_info failed\n", s);
+    exit(1);
+  }
+  if((fd = open("ioacct", O_CREATE|O_RDWR)) < 0 || write(fd, buf, sizeof(buf)) != sizeof(buf)){
+    printf("%s: create or write failed\n", s);
+    exit(1);
+  }
+  close(fd);
+  if((fd = open("ioacct", O_RDONLY)) < 0 || read(fd, buf, sizeof(buf)) != sizeof(buf)){
+    printf("%s: read failed\n", s);
+    exit(1);
+  }
+  close(fd);
+  unlink("ioacct");
+  if(ps_info(getpid(), &after) != 0){
+    printf("%s: ps_info failed\n", s);
+    exit(1);
+  }
+  if(after.read_bytes - before.read_bytes < sizeof(buf) || after.reads - before.reads < 1 ||
+     after.write_bytes - before.write_bytes < sizeof(buf) || after.writes - before.writes < 1){
+    printf("%s: read or write not counted\n", s);
+    exit(1);
+  }
+  if(after.log_blocks == before.log_blocks ||
+     after.cache_hits + after.cache_misses == before.cache_hits + before.cache_misses){
+    printf("%s: log or buffer cache not counted\n", s);
+    exit(1);
+  }
+}
+
+// a child touching an unmapped page is killed, and the fault is
+// counted as bad.
+void
+faultstattest(char *s)
+{
+  struct fault_stat before, after;
+  int pid, xstatus;
+
+  if(ps_faults(&before) != 0){
+    printf("%s: ps_faults failed\n", s);
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    *(volatile char*)(PGROUNDUP((uint64)sbrk(0)) + 10*PGSIZE) = 1;
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != -1){
+    printf("%s: child survived a bad fault\n", s);
+    exit(1);
+  }
+  if(ps_faults(&after) != 0 || after.faults[FAULT_BAD] == before.faults[FAULT_BAD]){
+    printf("%s: bad fault not counted\n", s);
+    exit(1);
+  }
+}
+
+// with lockstat on, the proc locks are counted as fork() and
+// wait() take them.
+void
+lockstattest(char *s)
+{
+  struct lock_stat *ls;
+  int n, i, pid;
+
+  if((ls = malloc(NLOCKSTAT * sizeof(*ls))) == 0){
+    printf("%s: malloc failed\n", s);
+    exit(1);
+  }
+  if(lockstat_ctl(1) < 0)
+    return;  // no LOCKSTAT in this kernel
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(0);
+  wait(0);
+  lockstat_ctl(0);
+  if((n = lockstat_read(ls, NLOCKSTAT)) < 0){
+    printf("%s: lockstat_read failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < n; i++)
+    if(strcmp(ls[i].name, "proc") == 0)
+      break;
+  if(i == n || ls[i].acquires == 0 || ls[i].hold_cycles == 0 ||
+     ls[i].contended > ls[i].acquires){
+    printf("%s: proc lock not counted\n", s);
+    exit(1);
+  }
+  free(ls);
+}
+
+// two processes hammer each kind of benchmark lock together.
+void
+lockbenchtest(char *s)
+{
+  int kind, pid, xstatus;
+
+  if(lockbench(SPIN_TICKET + 1, 10) != -1 || lockbench(SPIN_TAS, 0) != -1){
+    printf("%s: lockbench accepted bad arguments\n", s);
+    exit(1);
+  }
+  for(kind = SPIN_TAS; kind <= SPIN_TICKET; kind++){
+    pid = fork();
+    if(pid < 0){
+      printf("%s: fork failed\n", s);
+      exit(1);
+    }
+    int n = lockbench(kind, 20);
+    if(pid == 0)
+      exit(n > 0 ? 0 : 1);
+    wait(&xstatus);
+    if(n <= 0 || xstatus != 0){
+      printf("%s: lockbench of kind %d failed\n", s, kind);
+      exit(1);
+    }
+  }
+}
+
+// ps_blocked() reports a child stuck reading an empty pipe.
+void
+blockedtest(char *s)
+{
+  struct blocked_info *b;
+  int fds[2], pid, n, i, found = 0;
+  char c;
+
+  if((b = malloc(NPROC * sizeof(*b))) == 0 || pipe(fds) != 0){
+    printf("%s: malloc or pipe failed\n", s);
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    read(fds[0], &c, 1);
+    exit(0);
+  }
+  for(int tries = 0; tries < 100 && !found; tries++){
+    nanosleep(1000000);
+    if((n = ps_blocked(b, NPROC)) < 0){
+      printf("%s: ps_blocked failed\n", s);
+      exit(1);
+    }
+    for(i = 0; i < n; i++)
+      if(b[i].pid == pid)
+        found = 1;
+  }
+  for(i = 0; i < n && b[i].pid != pid; i++)
+    ;
+  if(!found || b[i].syscall != SYS_read || b[i].args[0] != fds[0] ||
+     b[i].wchan != WCHAN_PIPE || b[i].wchan_arg != 0){
+    printf("%s: child not reported blocked reading the pipe\n", s);
+    exit(1);
+  }
+  write(fds[1], "x", 1);
+  wait(0);
+  close(fds[0]);
+  close(fds[1]);
+  free(b);
+}
+
+// ps_info() tells what a process waits for: nothing while it
+// runs, the pipe while its child reads an empty one.
+void
+wchantest(char *s)
+{
+  struct process_info info;
+  int fds[2], pid, tries;
+  char c;
+
+  if(ps_info(getpid(), &info) != 0 || info.wchan != WCHAN_NONE || info.lock_holder != 0){
+    printf("%s: running process has a wait channel\n", s);
+    exit(1);
+  }
+  if(pipe(fds) != 0 || (pid = fork()) < 0){
+    printf("%s: pipe or fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    read(fds[0], &c, 1);
+    exit(0);
+  }
+  for(tries = 0; tries < 100; tries++){
+    nanosleep(1000000);
+    if(ps_info(pid, &info) != 0){
+      printf("%s: ps_info failed\n", s);
+      exit(1);
+    }
+    if(info.wchan == WCHAN_PIPE)
+      break;
+  }
+  if(tries == 100 || info.wchan_arg != 0){
+    printf("%s: child not waiting to read the pipe\n", s);
+    exit(1);
+  }
+  write(fds[1], "x", 1);
+  wait(0);
+  close(fds[0]);
+  close(fds[1]);
+}
+
 struct test {
   void (*f)(char *);
   char *s;
@@ -2635,6 +3269,23 @@ struct test {
   {sbrklast, "sbrklast"},
   {sbrk8000, "sbrk8000"},
   {badarg, "badarg" },
+  {clonetest, "clonetest" },
+  {futextest, "futextest" },
+  {nanosleeptest, "nanosleeptest" },
+  {vdsotest, "vdsotest" },
+  {ringtest, "ringtest" },
+  {stracetest, "stracetest" },
+  {snapshottest, "snapshottest" },
+  {vmcopytest, "vmcopytest" },
+  {ptwalktest, "ptwalktest" },
+  {rsstest, "rsstest" },
+  {blockedtest, "blockedtest" },
+  {syscallcounttest, "syscallcounttest" },
+  {wchantest, "wchantest" },
+  {ioacctest, "ioacctest" },
+  {faultstattest, "faultstattest" },
+  {lockstattest, "lockstattest" },
+  {lockbenchtest, "lockbenchtest" },
 
   { 0, 0},
 };
@@ -6,10 +6,13 @@ print "# generated by usys.pl - do not edit\n";
 
 print "#include \"kernel/syscall.h\"\n";
 
+# entry("name", "symbol") names the stub symbol instead,
+# for system calls ulib.c wraps.
 sub entry {
     my $name = shift;
-    print ".global $name\n";
-    print "${name}:\n";
+    my $symbol = shift || $name;
+    print ".global $symbol\n";
+    print "${symbol}:\n";
     print " li a7, SYS_${name}\n";
     print " ecall\n";
     print " ret\n";
@@ -32,10 +35,10 @@ entry("link");
 entry("mkdir");
 entry("chdir");
 entry("dup");
-entry("getpid");
+entry("getpid", "_getpid");
 entry("sbrk");
 entry("sleep");
-entry("uptime");
+entry("uptime", "_uptime");
 entry("dummy");
 entry("ps_list");
 entry("ps_info");
@@ -43,4 +46,28 @@ entry("ps_pt0");
 entry("ps_pt1");
 entry("ps_pt2");
 entry("ps_copy");
-entry("ps_sleep_write");
+entry("sched_setaffinity");
+entry("sched_getaffinity");
+entry("clone");
+entry("join");
+entry("futex");
+entry("ps_cpus");
+entry("nanosleep");
+entry("ring_setup");
+entry("ring_enter");
+entry("ps_syscalls");
+entry("ktrace_ctl");
+entry("ktrace_read");
+entry("prof_ctl");
+entry("prof_read");
+entry("trace");
+entry("trace_read");
+entry("ps_snapshot");
+entry("process_vm_readv");
+entry("process_vm_writev");
+entry("ps_pt_walk");
+entry("ps_blocked");
+entry("ps_faults");
+entry("lockstat_ctl");
+entry("lockstat_read");
+entry("lockbench");
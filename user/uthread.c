@@ -0,0 +1,149 @@
+// Threads on top of clone() and join(), and mutexes and
+// condition variables on top of futex().
+// thread_create() and thread_join() use malloc() for the
+// stacks, and malloc() is not thread-safe, so call them
+// from one thread only.
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/futex.h"
+#include "user/user.h"
+
+#define NTHREAD 64
+#define STACKSIZE 4096
+#define NSPIN 100  // tries before a contended mutex_lock() sleeps
+
+// stacks of the threads that haven't been joined yet.
+static struct {
+  int tid;
+  void *stack;
+} threads[NTHREAD];
+
+// clone() starts every thread here, since a thread
+// must not return from its start function.
+static void
+thread_start(void *fn, void *arg)
+{
+  ((void (*)(void*))fn)(arg);
+  exit(0);
+}
+
+// Run fn(arg) in a new thread sharing our memory.
+// Returns the thread id, or -1.
+int
+thread_create(void (*fn)(void*), void *arg)
+{
+  int i, tid;
+  char *stack;
+
+  for(i = 0; i < NTHREAD; i++)
+    if(threads[i].stack == 0)
+      break;
+  if(i == NTHREAD)
+    return -1;
+
+  if((stack = malloc(STACKSIZE)) == 0)
+    return -1;
+
+  // the stack grows down from its 16-byte aligned top.
+  tid = clone(thread_start, fn, arg, (void*)(((uint64)stack + STACKSIZE) & ~15L));
+  if(tid < 0){
+    free(stack);
+    return -1;
+  }
+  threads[i].tid = tid;
+  threads[i].stack = stack;
+  return tid;
+}
+
+// Wait for thread tid (or any thread, if tid is 0) to exit,
+// and free its stack. Returns the id of the joined thread.
+int
+thread_join(int tid)
+{
+  int i;
+
+  if((tid = join(tid)) < 0)
+    return -1;
+  for(i = 0; i < NTHREAD; i++){
+    if(threads[i].stack && threads[i].tid == tid){
+      free(threads[i].stack);
+      threads[i].stack = 0;
+      break;
+    }
+  }
+  return tid;
+}
+
+void
+mutex_init(struct mutex *m)
+{
+  m->state = 0;
+}
+
+void
+mutex_lock(struct mutex *m)
+{
+  int c = 1;
+
+  // the holder is likely running on another hart and about
+  // to let go, so spin in user space for a while first.
+  for(int i = 0; i < NSPIN; i++){
+    if(m->state == 0 && (c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+      return;
+  }
+
+  // contended: mark the mutex as waited on, so the holder's
+  // mutex_unlock() calls into the kernel, and sleep there
+  // until we manage to grab it.
+  if(c != 2)
+    c = __sync_lock_test_and_set(&m->state, 2);
+  while(c != 0){
+    futex(&m->state, FUTEX_WAIT, 2);
+    c = __sync_lock_test_and_set(&m->state, 2);
+  }
+}
+
+void
+mutex_unlock(struct mutex *m)
+{
+  // nobody waits unless the state was 2.
+  if(__sync_fetch_and_sub(&m->state, 1) != 1){
+    __sync_lock_release(&m->state);
+    futex(&m->state, FUTEX_WAKE, 1);
+  }
+}
+
+void
+cond_init(struct cond *c)
+{
+  c->seq = 0;
+}
+
+// Atomically unlock m and wait for a signal, then relock m.
+// Wakeups may be spurious, so callers recheck their condition.
+void
+cond_wait(struct cond *c, struct mutex *m)
+{
+  int seq = c->seq;
+
+  mutex_unlock(m);
+  // a signal between the unlock and here changes seq,
+  // and the kernel then won't put us to sleep.
+  futex(&c->seq, FUTEX_WAIT, seq);
+  mutex_lock(m);
+}
+
+void
+cond_signal(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex(&c->seq, FUTEX_WAKE, 1);
+}
+
+void
+cond_broadcast(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex(&c->seq, FUTEX_WAKE, NPROC);
+}